@@ -2,6 +2,8 @@
 
 #include "../lib/documenttemplate.h"
 #include "../lib/documentitem.h"
+#include "../lib/jsondocumentdatainterface.h"
+#include "../lib/renderplugin.h"
 
 #include <QWheelEvent>
 #include <QPainter>
@@ -9,10 +11,55 @@
 #include <QGuiApplication>
 #include <QPixmap>
 #include <QIcon>
+#include <QRunnable>
+#include <QMetaObject>
+#include <QMetaProperty>
+#include <QFontMetricsF>
+#include <QTimer>
+#include <QJsonObject>
+
+#include <algorithm>
 
 const qreal DocumentPreviewWidget::scaleBase = 2;
 const qreal DocumentPreviewWidget::scaleLevelMax = 4;
 const qreal DocumentPreviewWidget::scaleLevelMin = -4;
+const qreal DocumentPreviewWidget::lodScaleLevel = 1.5;
+
+constexpr int DocumentPreviewWidget::tileSize;
+constexpr int DocumentPreviewWidget::iconSize;
+
+class DocumentPreviewWidget::TileRenderJob : public QRunnable
+{
+public:
+	TileRenderJob(DocumentPreviewWidget* widget,
+				  QSharedPointer<const DocumentSnapshot> const& snapshot,
+				  int generation,
+				  TileKey const& key) :
+		_widget(widget),
+		_snapshot(snapshot),
+		_generation(generation),
+		_key(key)
+	{
+
+	}
+
+	void run() override {
+		QImage tile = DocumentPreviewWidget::paintTile(*_snapshot, std::pow(scaleBase, _key.level), QPoint(_key.x, _key.y));
+
+		QMetaObject::invokeMethod(_widget, "onTileRendered", Qt::QueuedConnection,
+								  Q_ARG(qreal, _key.level),
+								  Q_ARG(int, _key.x),
+								  Q_ARG(int, _key.y),
+								  Q_ARG(int, _generation),
+								  Q_ARG(QImage, tile));
+	}
+
+protected:
+	DocumentPreviewWidget* _widget;
+	QSharedPointer<const DocumentSnapshot> _snapshot;
+	int _generation;
+	TileKey _key;
+};
 
 DocumentPreviewWidget::DocumentPreviewWidget(QWidget *parent)
 	: QWidget{parent},
@@ -21,9 +68,50 @@ DocumentPreviewWidget::DocumentPreviewWidget(QWidget *parent)
 	  _pageMargin(25),
 	  _viewOrigin(0,0),
 	  _documentTemplate(nullptr),
+	  _snapshotGeneration(0),
+	  _snapshotDirty(true),
+	  _fullInvalidation(true),
+	  _tiles(96*1024), //cost in kB
+	  _tileInFlight(false),
+	  _dataInterface(nullptr),
+	  _pluginManager(new AutoQuill::RenderPluginManager()),
+	  _dataRenderer(nullptr),
+	  _dataLayoutMaxPages(0),
+	  _dataPageImagesScale(0),
 	  _previously_pressed(Qt::MouseButton::NoButton)
 {
+	//pixmaps cannot be used outside of the gui thread, so the tiles are painted with images.
+	_icons.resize(AutoQuill::DocumentItem::Invalid+1);
+	_icons[AutoQuill::DocumentItem::Condition] = QIcon(":/icons/condition.svg").pixmap(iconSize, iconSize).toImage();
+	_icons[AutoQuill::DocumentItem::Frame] = QIcon(":/icons/frame.svg").pixmap(iconSize, iconSize).toImage();
+	_icons[AutoQuill::DocumentItem::Image] = QIcon(":/icons/image.svg").pixmap(iconSize, iconSize).toImage();
+	_icons[AutoQuill::DocumentItem::List] = QIcon(":/icons/list.svg").pixmap(iconSize, iconSize).toImage();
+	_icons[AutoQuill::DocumentItem::Loop] = QIcon(":/icons/loop.svg").pixmap(iconSize, iconSize).toImage();
+	_icons[AutoQuill::DocumentItem::Plugin] = QIcon(":/icons/plugin.svg").pixmap(iconSize, iconSize).toImage();
+	_icons[AutoQuill::DocumentItem::Text] = QIcon(":/icons/text.svg").pixmap(iconSize, iconSize).toImage();
+	_icons[AutoQuill::DocumentItem::Page] = _icons[AutoQuill::DocumentItem::Frame];
+	_icons[AutoQuill::DocumentItem::Invalid] = _icons[AutoQuill::DocumentItem::Frame];
+
+	_tilePool.setMaxThreadCount(1);
+
+	//relayout the data preview only once the user stopped editing for a moment.
+	_dataLayoutTimer = new QTimer(this);
+	_dataLayoutTimer->setSingleShot(true);
+	_dataLayoutTimer->setInterval(150);
+	connect(_dataLayoutTimer, &QTimer::timeout, this, &DocumentPreviewWidget::layoutData);
+}
 
+DocumentPreviewWidget::~DocumentPreviewWidget() {
+	_tilePool.clear();
+	_tilePool.waitForDone();
+
+	_dataPages.clear();
+	_dataPagesOffsets.clear();
+	_dataLayout = AutoQuill::DocumentLayout();
+
+	delete _dataRenderer;
+	delete _dataInterface;
+	delete _pluginManager;
 }
 
 void DocumentPreviewWidget::setDocumentTemplate(AutoQuill::DocumentTemplate* docTemplate) {
@@ -32,9 +120,25 @@ void DocumentPreviewWidget::setDocumentTemplate(AutoQuill::DocumentTemplate* doc
 		return;
 	}
 
+	if (_documentTemplate != nullptr) {
+		disconnect(_documentTemplate, nullptr, this, nullptr);
+	}
+
 	_documentTemplate = docTemplate;
+
+	if (_documentTemplate != nullptr) {
+		connect(_documentTemplate, &AutoQuill::DocumentTemplate::reseted, this, &DocumentPreviewWidget::invalidate);
+	}
+
+	//the renderer is bound to the template.
+	_dataPages.clear();
+	_dataPagesOffsets.clear();
+	_dataLayout = AutoQuill::DocumentLayout();
+	delete _dataRenderer;
+	_dataRenderer = (_documentTemplate != nullptr) ? new AutoQuill::DocumentRenderer(*_documentTemplate) : nullptr;
+
+	invalidate();
 	gotoPage(0);
-	repaint();
 
 }
 
@@ -142,12 +246,54 @@ void DocumentPreviewWidget::gotoPage(int pageId) {
 
 	setViewOrigin(QPointF(pos_horz, pos_vert));
 	setZoomLevel(scaleLevel);
-	repaint();
+	update();
+
+}
+
+void DocumentPreviewWidget::invalidate() {
+	_itemSizes.clear(); //items might have been moved or deleted.
+	_fullInvalidation = true;
+	_snapshotDirty = true;
+
+	if (isDataPreview()) {
+		scheduleDataLayout();
+	}
+
+	update();
+}
+
+void DocumentPreviewWidget::setPreviewData(QJsonObject const& data) {
+
+	delete _dataInterface;
+	_dataInterface = new AutoQuill::JsonDocumentDataInterface(data);
+
+	layoutData();
+}
+
+void DocumentPreviewWidget::clearPreviewData() {
 
+	if (!isDataPreview()) {
+		return;
+	}
+
+	_dataLayoutTimer->stop();
+
+	_dataPages.clear();
+	_dataPagesOffsets.clear();
+	_dataLayout = AutoQuill::DocumentLayout();
+	_dataPageImages.clear();
+	_dataLayoutError.clear();
+
+	delete _dataInterface;
+	_dataInterface = nullptr;
+
+	update();
 }
 
 void DocumentPreviewWidget::paintEvent(QPaintEvent *event) {
 
+	Q_UNUSED(event);
+
 	QPainter painter(this);
 
 	QSize s = rect().size();
@@ -157,35 +303,75 @@ void DocumentPreviewWidget::paintEvent(QPaintEvent *event) {
 		return;
 	}
 
-	qreal pos_horz = 0;
-	qreal pos_vert = 0;
+	if (isDataPreview()) {
+		paintDataPreview(painter);
+		return;
+	}
 
-	for (int i = 0; i < _documentTemplate->subitems().size(); i++) {
+	if (_snapshotDirty or _snapshot.isNull()) {
+		rebuildSnapshot();
+	}
 
-		QPointF offset(pos_horz, pos_vert);
+	//the tiles are in "canvas" coordinates, i.e. the document at the current scale,
+	//panning is then just a translation of the canvas.
+	qreal currentScale = scale();
+	QPointF canvasOffset = QPointF(_docMargin, _docMargin) - _viewOrigin/currentScale;
+	QPoint tilesOrigin(qRound(canvasOffset.x()), qRound(canvasOffset.y()));
 
-		paintPage(offset, i, painter);
+	//first draw the tiles from other zoom levels, scaled, while the current level is being rendered.
+	QList<TileKey> fallbackTiles;
 
-		AutoQuill::DocumentItem* item = _documentTemplate->subitems()[i];
+	for (TileKey const& key : _tiles.keys()) {
+		if (key.level == _scale_level) {
+			continue;
+		}
+		if (doc2widgetRect(tileDocRect(key)).intersects(rect())) {
+			fallbackTiles.push_back(key);
+		}
+	}
 
-		while (item->getType() != AutoQuill::DocumentItem::Page) {
+	//the closest zoom levels are drawn last, as they are the most detailed.
+	std::sort(fallbackTiles.begin(), fallbackTiles.end(), [this] (TileKey const& k1, TileKey const& k2) {
+		return std::abs(k1.level - _scale_level) > std::abs(k2.level - _scale_level);
+	});
 
-			if (item->subitems().isEmpty()) {
-				item = nullptr;
-				break;
-			}
+	painter.setRenderHint(QPainter::SmoothPixmapTransform);
 
-			item = item->subitems()[0];
+	for (TileKey const& key : qAsConst(fallbackTiles)) {
+		QPixmap* tile = _tiles.object(key);
+		if (tile != nullptr) {
+			painter.drawPixmap(doc2widgetRect(tileDocRect(key)), *tile, QRectF(tile->rect()));
 		}
+	}
 
-		if (item == nullptr) {
-			pos_vert += 2*_pageMargin;
-		} else {
-			pos_vert += 2*_pageMargin + item->initialHeight();
-		}
+	painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+
+	//then the tiles at the current zoom level, queuing the missing ones.
+	QRect visibleCanvas = rect().translated(-tilesOrigin);
+
+	int x0 = std::floor(qreal(visibleCanvas.left())/tileSize);
+	int x1 = std::floor(qreal(visibleCanvas.right())/tileSize);
+	int y0 = std::floor(qreal(visibleCanvas.top())/tileSize);
+	int y1 = std::floor(qreal(visibleCanvas.bottom())/tileSize);
+
+	_tileQueue.clear();
+
+	for (int ty = y0; ty <= y1; ty++) {
+		for (int tx = x0; tx <= x1; tx++) {
+
+			TileKey key{_scale_level, tx, ty};
+			QPixmap* tile = _tiles.object(key);
 
+			if (tile != nullptr) {
+				painter.drawPixmap(tilesOrigin + QPoint(tx*tileSize, ty*tileSize), *tile);
+			} else if (!_tileInFlight or !(_inFlightTile == key)) {
+				_tileQueue.push_back(key);
+			}
+		}
 	}
 
+	startNextTileJob();
+
 }
 void DocumentPreviewWidget::keyPressEvent(QKeyEvent *event) {
 	QWidget::keyPressEvent(event);
@@ -286,52 +472,13 @@ void DocumentPreviewWidget::mouseMoveEvent(QMouseEvent *event) {
 	}
 }
 
-void DocumentPreviewWidget::paintPage(QPointF offset, int pageId, QPainter& painter) {
-
-	if (_documentTemplate == nullptr) {
-		return;
-	}
-
-	AutoQuill::DocumentItem* item = _documentTemplate->subitems()[pageId];
-
-	while (item->getType() != AutoQuill::DocumentItem::Page) {
-
-		if (item->subitems().isEmpty()) {
-			item = nullptr;
-			break;
-		}
-
-		item = item->subitems()[0];
-	}
-
-	if (item == nullptr) {
-		return;
-	}
-
-	QPointF origin = offset + QPointF(_pageMargin, _pageMargin);
-
-	QRectF pageRect(origin,
-					QSizeF(item->initialWidth(), item->initialHeight()));
-
-	QRectF widgetRect = doc2widgetRect(pageRect);
-
-	if (!widgetRect.intersects(rect())) {
-		return; //page not visible
-	}
-
-	painter.fillRect(widgetRect, QColor(255,255,255));
-
-	QTransform initial = painter.worldTransform();
-	painter.translate(widgetRect.topLeft());
-
-	for (int i = 0; i < item->subitems().size(); i++) {
-		paintItem(item->subitems()[i], painter);
-	}
+QSizeF DocumentPreviewWidget::computeItemSize(AutoQuill::DocumentItem* item) {
 
-	painter.setWorldTransform(initial); //reset the transform;
-}
+    auto cached = _itemSizes.constFind(item);
 
-QSizeF DocumentPreviewWidget::computeItemSize(AutoQuill::DocumentItem* item) {
+    if (cached != _itemSizes.constEnd()) {
+        return cached.value();
+    }
 
     QSizeF size(item->initialWidth(), item->initialHeight());
 
@@ -385,46 +532,496 @@ QSizeF DocumentPreviewWidget::computeItemSize(AutoQuill::DocumentItem* item) {
         size.rheight() = item->maxHeight();
     }
 
+    _itemSizes.insert(item, size);
+
     return size;
 
 }
 
-QSizeF DocumentPreviewWidget::paintItem(AutoQuill::DocumentItem* item, QPainter& painter) {
+void DocumentPreviewWidget::rebuildSnapshot() {
 
-	constexpr int iconSize = 30;
+	QSharedPointer<DocumentSnapshot> snapshot(new DocumentSnapshot());
+	snapshot->icons = _icons;
+	snapshot->font = font();
 
-	static QPixmap conditionIcon = QIcon(":/icons/condition.svg").pixmap(iconSize, iconSize);
-	static QPixmap frameIcon = QIcon(":/icons/frame.svg").pixmap(iconSize, iconSize);
-	static QPixmap imageIcon = QIcon(":/icons/image.svg").pixmap(iconSize, iconSize);
-	static QPixmap listIcon = QIcon(":/icons/list.svg").pixmap(iconSize, iconSize);
-	static QPixmap loopIcon = QIcon(":/icons/loop.svg").pixmap(iconSize, iconSize);
-	static QPixmap pluginIcon = QIcon(":/icons/plugin.svg").pixmap(iconSize, iconSize);
-	static QPixmap textIcon = QIcon(":/icons/text.svg").pixmap(iconSize, iconSize);
+	if (_documentTemplate != nullptr) {
 
-	AutoQuill::DocumentItem::Type type = item->getType();
+		qreal pos_vert = 0;
 
-	auto iconSelect = [&] (AutoQuill::DocumentItem::Type type) -> QPixmap& {
+		for (int i = 0; i < _documentTemplate->subitems().size(); i++) {
 
-		switch(type) {
-		case AutoQuill::DocumentItem::Condition:
-			return conditionIcon;
-		case AutoQuill::DocumentItem::Image:
-			return imageIcon;
-		case AutoQuill::DocumentItem::List:
-			return listIcon;
-		case AutoQuill::DocumentItem::Loop:
-			return loopIcon;
-		case AutoQuill::DocumentItem::Plugin:
-			return pluginIcon;
-		case AutoQuill::DocumentItem::Text:
-			return textIcon;
-		case AutoQuill::DocumentItem::Frame:
-		default:
-			return frameIcon;
+			AutoQuill::DocumentItem* item = _documentTemplate->subitems()[i];
+
+			trackItem(item);
+
+			while (item->getType() != AutoQuill::DocumentItem::Page) {
+
+				if (item->subitems().isEmpty()) {
+					item = nullptr;
+					break;
+				}
+
+				item = item->subitems()[0];
+			}
+
+			PageSnapshot page;
+			page.valid = item != nullptr;
+			page.labelExtent = QSizeF(0,0);
+
+			//unchanged pages can reuse their previous snapshot.
+			bool reuseItems = !_fullInvalidation and !_snapshot.isNull() and
+					i < _snapshot->pages.size() and !_dirtyPages.contains(i);
+
+			if (item == nullptr) {
+				page.rect = QRectF(QPointF(_pageMargin, pos_vert + _pageMargin), QSizeF(0, 0));
+				pos_vert += 2*_pageMargin;
+			} else {
+				page.rect = QRectF(QPointF(_pageMargin, pos_vert + _pageMargin),
+								   QSizeF(item->initialWidth(), item->initialHeight()));
+
+				if (reuseItems) {
+					page.items = _snapshot->pages[i].items;
+					page.itemsBounds = _snapshot->pages[i].itemsBounds;
+					page.labelExtent = _snapshot->pages[i].labelExtent;
+					page.thumbnail = _snapshot->pages[i].thumbnail;
+				} else {
+					for (AutoQuill::DocumentItem* subitem : item->subitems()) {
+						ItemSnapshot itemSnapshot = snapshotItem(subitem);
+						page.itemsBounds = page.itemsBounds.united(itemSnapshot.bounds);
+						page.labelExtent = page.labelExtent.expandedTo(itemSnapshot.labelExtent);
+						page.items.push_back(itemSnapshot);
+					}
+				}
+
+				if (page.thumbnail.isNull()) {
+					page.thumbnail = QSharedPointer<PageThumbnail>(new PageThumbnail());
+				}
+
+				pos_vert += 2*_pageMargin + item->initialHeight();
+			}
+
+			snapshot->pages.push_back(page);
+		}
+	}
+
+	bool geometryChanged = _snapshot.isNull() or _snapshot->pages.size() != snapshot->pages.size();
+
+	for (int i = 0; !geometryChanged and i < snapshot->pages.size(); i++) {
+		geometryChanged = _snapshot->pages[i].valid != snapshot->pages[i].valid or
+				_snapshot->pages[i].rect != snapshot->pages[i].rect;
+	}
+
+	if (_fullInvalidation or geometryChanged) {
+		//page geometry changes move all the following pages.
+		_tiles.clear();
+	} else {
+		for (int pageId : qAsConst(_dirtyPages)) {
+			if (pageId < 0 or pageId >= snapshot->pages.size()) {
+				continue;
+			}
+			//the items might have moved out of, or into, the margins and the area of the next pages.
+			invalidatePageTiles(_snapshot->pages[pageId], snapshot->pages[pageId]);
+		}
+	}
+
+	_snapshot = snapshot;
+	_snapshotGeneration++;
+	_snapshotDirty = false;
+	_fullInvalidation = false;
+	_dirtyPages.clear();
+}
+
+DocumentPreviewWidget::ItemSnapshot DocumentPreviewWidget::snapshotItem(AutoQuill::DocumentItem* item) {
+
+	ItemSnapshot snapshot;
+
+	snapshot.type = item->getType();
+	snapshot.direction = item->direction();
+	snapshot.pos = QPointF(item->posX(), item->posY());
+	snapshot.origin = item->origin();
+	snapshot.size = computeItemSize(item);
+	snapshot.name = item->objectName();
+	snapshot.borderColor = item->borderColor();
+	snapshot.borderWidth = item->borderWidth();
+	snapshot.fillColor = item->fillColor();
+
+	QFontMetricsF metrics(font());
+	snapshot.labelExtent = QSizeF(iconSize + metrics.boundingRect(snapshot.name).width(),
+								  iconSize + metrics.descent());
+
+	//follow the offsets applied by paintItem.
+	qreal borderMargin = std::max<qreal>(0, snapshot.borderWidth)/2;
+	snapshot.bounds = QRectF(snapshot.pos, snapshot.size).adjusted(-borderMargin, -borderMargin, borderMargin, borderMargin);
+	QPointF offset = snapshot.pos;
+
+	bool isHorizontal = snapshot.direction == AutoQuill::DocumentItem::Left2Right;
+
+	for (AutoQuill::DocumentItem* subitem : item->subitems()) {
+		ItemSnapshot subSnapshot = snapshotItem(subitem);
+
+		snapshot.bounds = snapshot.bounds.united(subSnapshot.bounds.translated(offset));
+		snapshot.labelExtent = snapshot.labelExtent.expandedTo(subSnapshot.labelExtent);
+
+		if (snapshot.type == AutoQuill::DocumentItem::List) {
+			if (isHorizontal) {
+				offset.rx() += subSnapshot.origin.x() + subSnapshot.size.width();
+			} else {
+				offset.ry() += subSnapshot.origin.y() + subSnapshot.size.height();
+			}
+		}
+
+		snapshot.subitems.push_back(subSnapshot);
+	}
+
+	return snapshot;
+}
+
+void DocumentPreviewWidget::trackItem(AutoQuill::DocumentItem* item) {
+
+	static const QMetaMethod changedSlot = staticMetaObject.method(staticMetaObject.indexOfSlot("onItemChanged()"));
+
+	QMetaObject const* metaObject = item->metaObject();
+
+	for (int i = 0; i < metaObject->propertyCount(); i++) {
+		QMetaProperty property = metaObject->property(i);
+
+		if (property.hasNotifySignal()) {
+			connect(item, property.notifySignal(), this, changedSlot, Qt::UniqueConnection);
+		}
+	}
+
+	for (AutoQuill::DocumentItem* subitem : item->subitems()) {
+		trackItem(subitem);
+	}
+}
+
+void DocumentPreviewWidget::onItemChanged() {
+
+	AutoQuill::DocumentItem* item = qobject_cast<AutoQuill::DocumentItem*>(sender());
+
+	if (item == nullptr or _documentTemplate == nullptr) {
+		return;
+	}
+
+	//the size of the ancestors depends on the size of the item.
+	_itemSizes.remove(item);
+
+	AutoQuill::DocumentItem* parentItem = qobject_cast<AutoQuill::DocumentItem*>(item->parent());
+
+	while (parentItem != nullptr) {
+		item = parentItem;
+		_itemSizes.remove(item);
+		parentItem = qobject_cast<AutoQuill::DocumentItem*>(item->parent());
+	}
+
+	int pageId = _documentTemplate->subitems().indexOf(item);
+
+	if (pageId < 0) {
+		return; //item not in the document anymore
+	}
+
+	_dirtyPages.insert(pageId);
+	_snapshotDirty = true;
+
+	if (isDataPreview()) {
+		scheduleDataLayout();
+	}
+
+	update();
+}
+
+int DocumentPreviewWidget::dataPagesNeeded() const {
+
+	if (_documentTemplate == nullptr) {
+		return 0;
+	}
+
+	//the pages of the layout are at least as high as the smallest page in the template.
+	qreal minPageHeight = -1;
+
+	for (AutoQuill::DocumentItem* item : _documentTemplate->subitems()) {
+
+		while (item != nullptr and item->getType() != AutoQuill::DocumentItem::Page) {
+			item = item->subitems().isEmpty() ? nullptr : item->subitems()[0];
+		}
+
+		if (item != nullptr and (minPageHeight < 0 or item->initialHeight() < minPageHeight)) {
+			minPageHeight = item->initialHeight();
+		}
+	}
+
+	if (minPageHeight < 0) {
+		return 0;
+	}
+
+	qreal visibleBottom = widget2docPoint(QPointF(0, height())).y();
+	int nPages = std::ceil(std::max<qreal>(0, visibleBottom)/(minPageHeight + 2*_pageMargin));
+
+	return nPages + 1;
+}
+
+void DocumentPreviewWidget::scheduleDataLayout() {
+	_dataLayoutTimer->start();
+}
+
+void DocumentPreviewWidget::layoutData() {
+
+	_dataLayoutTimer->stop();
+
+	if (_dataInterface == nullptr or _dataRenderer == nullptr or _documentTemplate == nullptr) {
+		return;
+	}
+
+	//track the items, so that the preview is refreshed when they are edited.
+	for (AutoQuill::DocumentItem* item : _documentTemplate->subitems()) {
+		trackItem(item);
+	}
+
+	int maxPages = dataPagesNeeded();
+
+	//the layout is done in points, at 72 dpi, as for the pdf output.
+	QImage metricsDevice(1, 1, QImage::Format_ARGB32_Premultiplied);
+	int dotsPerMeter = qRound(72/0.0254);
+	metricsDevice.setDotsPerMeterX(dotsPerMeter);
+	metricsDevice.setDotsPerMeterY(dotsPerMeter);
+
+	QPainter metricsPainter(&metricsDevice);
+
+	_dataPages.clear();
+	_dataPagesOffsets.clear();
+	AutoQuill::DocumentRenderer::LayoutResults results = _dataRenderer->layoutHeadless(_dataInterface, *_pluginManager, &metricsPainter, maxPages);
+
+	metricsPainter.end();
+
+	_dataLayout = results.layout;
+	_dataLayoutMaxPages = maxPages;
+	_dataLayoutError = (results.status.status != AutoQuill::DocumentRenderer::Success) ? results.status.message : QString();
+
+	AutoQuill::DocumentRenderer::collectLayoutPages(_dataLayout.items(), _dataPages, &_dataPagesOffsets);
+
+	_dataPageImages.clear();
+
+	update();
+}
+
+void DocumentPreviewWidget::paintDataPreview(QPainter& painter) {
+
+	//more pages might be needed after a zoom out or a scroll.
+	if (_dataPages.size() >= _dataLayoutMaxPages and dataPagesNeeded() > _dataLayoutMaxPages) {
+		scheduleDataLayout();
+	}
+
+	if (_dataPageImagesScale != scale()) {
+		_dataPageImages.clear();
+		_dataPageImagesScale = scale();
+	}
+
+	qreal s = 1/scale();
+	qreal pos_vert = 0;
+
+	for (int i = 0; i < _dataPages.size(); i++) {
+
+		AutoQuill::ItemRenderInfos* page = _dataPages[i];
+
+		QRectF pageRect(QPointF(_pageMargin, pos_vert + _pageMargin), page->currentSize);
+		pos_vert += 2*_pageMargin + page->currentSize.height();
+
+		QRectF widgetRect = doc2widgetRect(pageRect);
+
+		if (!widgetRect.intersects(rect())) {
+			continue; //page not visible
+		}
+
+		if (!_dataPageImages.contains(i)) {
+
+			QSize imageSize = widgetRect.size().toSize().expandedTo(QSize(1,1));
+
+			QImage pageImage(imageSize, QImage::Format_ARGB32_Premultiplied);
+			pageImage.fill(QColor(255,255,255));
+
+			//render with the same metrics as the layout, scaled to the view.
+			int dotsPerMeter = qRound(72/0.0254);
+			pageImage.setDotsPerMeterX(dotsPerMeter);
+			pageImage.setDotsPerMeterY(dotsPerMeter);
+
+			QPainter pagePainter(&pageImage);
+			pagePainter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+			pagePainter.scale(s, s);
+			pagePainter.translate(-(page->currentOrigin + _dataPagesOffsets[i]));
+
+			_dataRenderer->renderItemToExternalPainter(*page, &pagePainter, _dataPagesOffsets[i]);
+
+			pagePainter.end();
+
+			_dataPageImages.insert(i, pageImage);
+		}
+
+		painter.drawImage(widgetRect.topLeft(), _dataPageImages.value(i));
+	}
+
+	if (!_dataLayoutError.isEmpty()) {
+		painter.setPen(QColor(180, 0, 0));
+		painter.drawText(rect().adjusted(5, 5, -5, -5), Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, _dataLayoutError);
+	}
+}
+
+void DocumentPreviewWidget::invalidatePageTiles(PageSnapshot const& oldPage, PageSnapshot const& newPage) {
+
+	for (TileKey const& key : _tiles.keys()) {
+
+		//the labels have a fixed size in pixels, so the painted region depends on the zoom level of the tile.
+		qreal tileScale = std::pow(scaleBase, key.level);
+		QRectF paintedRect = pagePaintedRect(oldPage, tileScale).united(pagePaintedRect(newPage, tileScale));
+
+		QRectF tileRect(key.x*tileSize, key.y*tileSize, tileSize, tileSize);
+
+		if (tileRect.intersects(paintedRect)) {
+			_tiles.remove(key);
+		}
+	}
+}
+
+QRectF DocumentPreviewWidget::tileDocRect(TileKey const& key) const {
+	qreal tileScale = std::pow(scaleBase, key.level);
+	return QRectF(key.x*tileSize*tileScale, key.y*tileSize*tileScale, tileSize*tileScale, tileSize*tileScale);
+}
+
+void DocumentPreviewWidget::startNextTileJob() {
+
+	if (_tileInFlight or _tileQueue.isEmpty() or _snapshot.isNull()) {
+		return;
+	}
+
+	_inFlightTile = _tileQueue.takeFirst();
+	_tileInFlight = true;
+
+	_tilePool.start(new TileRenderJob(this, _snapshot, _snapshotGeneration, _inFlightTile));
+}
+
+void DocumentPreviewWidget::onTileRendered(qreal level, int x, int y, int generation, QImage image) {
+
+	_tileInFlight = false;
+
+	if (generation == _snapshotGeneration and !image.isNull()) {
+		_tiles.insert(TileKey{level, x, y}, new QPixmap(QPixmap::fromImage(image)), tileSize*tileSize*4/1024);
+		update();
+	} else if (generation != _snapshotGeneration) {
+		update(); //the tile was skipped by the repaints while it was in flight, queue it again from the new snapshot
+	}
+
+	startNextTileJob();
+}
+
+QImage DocumentPreviewWidget::paintTile(DocumentSnapshot const& snapshot, qreal scale, QPoint const& tile) {
+
+	QImage image(tileSize, tileSize, QImage::Format_ARGB32_Premultiplied);
+	image.fill(QColor(120, 120, 120));
+
+	QRectF tileRect(tile.x()*tileSize, tile.y()*tileSize, tileSize, tileSize);
+
+	QPainter painter(&image);
+	painter.setFont(snapshot.font);
+	painter.translate(-tileRect.topLeft());
+
+	QRectF exposed(0, 0, tileSize, tileSize);
+
+	bool lowDetail = scale > std::pow(scaleBase, lodScaleLevel);
+
+	for (PageSnapshot const& page : snapshot.pages) {
+
+		if (!page.valid) {
+			continue;
+		}
+
+		if (!pagePaintedRect(page, scale).intersects(tileRect)) {
+			continue; //page not visible on this tile
+		}
+
+		if (lowDetail) {
+			QRectF canvasRect(page.rect.topLeft()/scale, page.rect.size()/scale);
+			QImage thumbnail = pageThumbnail(snapshot, page);
+
+			painter.setRenderHint(QPainter::SmoothPixmapTransform);
+			painter.drawImage(canvasRect, thumbnail, QRectF(thumbnail.rect()));
+			continue;
 		}
-	};
 
-	QPixmap& icon = iconSelect(type);
+		paintPage(snapshot, page, scale, painter, exposed);
+	}
+
+	painter.end();
+
+	return image;
+}
+
+QImage DocumentPreviewWidget::pageThumbnail(DocumentSnapshot const& snapshot, PageSnapshot const& page) {
+
+	QMutexLocker locker(&page.thumbnail->mutex);
+
+	if (!page.thumbnail->image.isNull()) {
+		return page.thumbnail->image;
+	}
+
+	qreal scale = std::pow(scaleBase, lodScaleLevel);
+	QSize size = (page.rect.size()/scale).toSize().expandedTo(QSize(1,1));
+
+	QImage thumbnail(size, QImage::Format_ARGB32_Premultiplied);
+	thumbnail.fill(QColor(255,255,255));
+
+	QPainter painter(&thumbnail);
+	painter.setFont(snapshot.font);
+	painter.translate(-page.rect.topLeft()/scale);
+
+	paintPage(snapshot, page, scale, painter, QRectF(thumbnail.rect()));
+
+	painter.end();
+
+	page.thumbnail->image = thumbnail;
+	return thumbnail;
+}
+
+QRectF DocumentPreviewWidget::pagePaintedRect(PageSnapshot const& page, qreal scale) {
+
+	QRectF canvasRect(page.rect.topLeft()/scale, page.rect.size()/scale);
+
+	//items and their labels might overflow the page
+	QRectF itemsRect(page.itemsBounds.topLeft()/scale, page.itemsBounds.size()/scale);
+	itemsRect.adjust(-2, -2, page.labelExtent.width() + 2, page.labelExtent.height() + 2);
+
+	return canvasRect.united(itemsRect.translated(canvasRect.topLeft()));
+}
+
+void DocumentPreviewWidget::paintPage(DocumentSnapshot const& snapshot, PageSnapshot const& page, qreal scale, QPainter& painter, QRectF const& exposed) {
+
+	QRectF canvasRect(page.rect.topLeft()/scale, page.rect.size()/scale);
+
+	painter.fillRect(canvasRect, QColor(255,255,255));
+
+	QTransform initial = painter.worldTransform();
+	painter.translate(canvasRect.topLeft());
+
+	for (ItemSnapshot const& item : page.items) {
+		paintItem(snapshot, item, scale, painter, exposed);
+	}
+
+	painter.setWorldTransform(initial); //reset the transform;
+}
+
+void DocumentPreviewWidget::paintItem(DocumentSnapshot const& snapshot, ItemSnapshot const& item, qreal scale, QPainter& painter, QRectF const& exposed) {
+
+	qreal s = 1/scale;
+
+	//skip the whole subtree if it is not exposed (with some margin for the pen width).
+	QRectF subtreeRect(item.bounds.topLeft()*s, item.bounds.size()*s);
+	subtreeRect.adjust(-2, -2, item.labelExtent.width() + 2, item.labelExtent.height() + 2);
+
+	if (!painter.worldTransform().mapRect(subtreeRect).intersects(exposed)) {
+		return;
+	}
+
+	AutoQuill::DocumentItem::Type type = item.type;
+
+	QImage const& icon = snapshot.icons[type];
 
 	QPen borderPen;
 	borderPen.setColor(QColor(44,87,164));
@@ -432,63 +1029,70 @@ QSizeF DocumentPreviewWidget::paintItem(AutoQuill::DocumentItem* item, QPainter&
 	borderPen.setStyle(Qt::DashLine);
 	borderPen.setJoinStyle(Qt::MiterJoin);
 
-	QPointF pos(item->posX(), item->posY());
-	qreal s = 1/scale();
+	QPointF pos = item.pos;
 	pos *= s;
 
-	if (item->getType() == AutoQuill::DocumentItem::Frame) {
-		if (item->borderColor().isValid()) {
-			borderPen.setColor(item->borderColor());
+	qreal penMargin = 2 + std::max<qreal>(0, item.borderWidth)*s/2;
+	QRectF ownRect = QRectF(pos, s*item.size).united(QRectF(pos, QSizeF(iconSize, iconSize)));
+	ownRect.adjust(-penMargin, -penMargin, penMargin, penMargin);
+	bool ownVisible = painter.worldTransform().mapRect(ownRect).intersects(exposed) or
+			painter.worldTransform().mapRect(QRectF(pos, item.labelExtent)).intersects(exposed);
+
+	if (type == AutoQuill::DocumentItem::Frame) {
+		if (item.borderColor.isValid()) {
+			borderPen.setColor(item.borderColor);
 		}
 
-		if (item->borderWidth() > 0) {
-			borderPen.setWidthF(item->borderWidth()*s);
+		if (item.borderWidth > 0) {
+			borderPen.setWidthF(item.borderWidth*s);
 			borderPen.setStyle(Qt::SolidLine);
 		}
 	}
 
-    QSizeF itemSize = computeItemSize(item);
+	if (ownVisible) { //otherwise only some subitems are exposed
 
-	switch(type) {
-	case AutoQuill::DocumentItem::Frame:
-	case AutoQuill::DocumentItem::Image:
-	case AutoQuill::DocumentItem::List:
-	case AutoQuill::DocumentItem::Loop:
-	case AutoQuill::DocumentItem::Plugin:
-	case AutoQuill::DocumentItem::Text: {
+		switch(type) {
+		case AutoQuill::DocumentItem::Frame:
+		case AutoQuill::DocumentItem::Image:
+		case AutoQuill::DocumentItem::List:
+		case AutoQuill::DocumentItem::Loop:
+		case AutoQuill::DocumentItem::Plugin:
+		case AutoQuill::DocumentItem::Text: {
 
-        QRectF rect(pos, s*itemSize);
+			QRectF rect(pos, s*item.size);
 
-		if (type == AutoQuill::DocumentItem::Frame and item->fillColor().isValid()) {
-			painter.fillRect(rect, item->fillColor());
-		}
+			if (type == AutoQuill::DocumentItem::Frame and item.fillColor.isValid()) {
+				painter.fillRect(rect, item.fillColor);
+			}
 
-		painter.setPen(borderPen);
-		painter.drawRect(rect);
-		painter.drawPixmap(pos,icon);
-		painter.drawText(pos + QPointF(iconSize,iconSize), item->objectName());
+			painter.setPen(borderPen);
+			painter.drawRect(rect);
+			painter.drawImage(pos,icon);
+			painter.drawText(pos + QPointF(iconSize,iconSize), item.name);
+		}
+			break;
+		default:
+			painter.setPen(borderPen);
+			painter.drawImage(pos,icon);
+			painter.drawText(pos + QPointF(iconSize,iconSize), item.name);
+		}
 	}
-		break;
-	default:
-		painter.setPen(borderPen);
-		painter.drawPixmap(pos,icon);
-		painter.drawText(pos + QPointF(iconSize,iconSize), item->objectName());
-    }
 
 
     QTransform initial = painter.worldTransform();
     painter.translate(pos);
 
-    for (int i = 0; i < item->subitems().size(); i++) {
+    for (ItemSnapshot const& subitem : item.subitems) {
         qreal delta = 0;
-        qreal accumulated = 0;
         bool isHorizontal = false;
 
-        QPointF subPos = item->subitems()[i]->origin();
-        QSizeF subSize = paintItem(item->subitems()[i], painter);
+        QPointF subPos = subitem.origin;
+        QSizeF subSize = subitem.size;
+
+        paintItem(snapshot, subitem, scale, painter, exposed);
 
         if (type == AutoQuill::DocumentItem::List) {
-            if (item->direction() == AutoQuill::DocumentItem::Left2Right or item->direction() == AutoQuill::DocumentItem::Left2Right) {
+            if (item.direction == AutoQuill::DocumentItem::Left2Right or item.direction == AutoQuill::DocumentItem::Left2Right) {
                 isHorizontal = true;
             }
 
@@ -498,8 +1102,6 @@ QSizeF DocumentPreviewWidget::paintItem(AutoQuill::DocumentItem* item, QPainter&
                 delta = subPos.y()+subSize.height();
             }
 
-            accumulated += delta;
-
             if (isHorizontal) {
                 painter.translate(QPointF(delta*s, 0));
             } else {
@@ -511,6 +1113,4 @@ QSizeF DocumentPreviewWidget::paintItem(AutoQuill::DocumentItem* item, QPainter&
 
     painter.setWorldTransform(initial); //reset the transform;
 
-    return itemSize;
-
 }
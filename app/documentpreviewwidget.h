@@ -5,12 +5,31 @@
 
 #include <QPoint>
 #include <QSize>
+#include <QColor>
+#include <QFont>
+#include <QImage>
+#include <QPixmap>
+#include <QCache>
+#include <QSet>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QMutex>
 
 #include <cmath>
 
+#include "../lib/documentitem.h"
+#include "../lib/documentrenderer.h"
+
+class QTimer;
+class QJsonObject;
+
 namespace AutoQuill {
 	class DocumentTemplate;
-	class DocumentItem;
+	class JsonDocumentDataInterface;
+	class RenderPluginManager;
 }
 
 class DocumentPreviewWidget : public QWidget
@@ -18,6 +37,7 @@ class DocumentPreviewWidget : public QWidget
 	Q_OBJECT
 public:
 	explicit DocumentPreviewWidget(QWidget *parent = nullptr);
+	~DocumentPreviewWidget();
 
 	void setDocumentTemplate(AutoQuill::DocumentTemplate* docTemplate);
 
@@ -37,7 +57,7 @@ public:
 		if (level != _scale_level) {
 			_scale_level = level;
 			Q_EMIT scaleChanged();
-			repaint();
+			update();
 		}
 	}
 
@@ -54,7 +74,7 @@ public:
 		if (_viewOrigin != pos) {
 			_viewOrigin = pos;
 			Q_EMIT viewOriginChanged();
-			repaint();
+			update();
 		}
 	}
 
@@ -111,6 +131,27 @@ public:
 		return widget2doc;
 	}
 
+	/*!
+	 * \brief invalidate drop all the cached tiles, e.g. after the structure of the template changed.
+	 */
+	void invalidate();
+
+	/*!
+	 * \brief setPreviewData switch the preview to the data mode, showing the rendered document for some sample data.
+	 * \param data the sample data
+	 *
+	 * Only the pages up to the visible ones are laid out, and the layout is refreshed shortly after the template is edited.
+	 */
+	void setPreviewData(QJsonObject const& data);
+	/*!
+	 * \brief clearPreviewData switch the preview back to the template wireframes.
+	 */
+	void clearPreviewData();
+
+	inline bool isDataPreview() const {
+		return _dataInterface != nullptr;
+	}
+
 Q_SIGNALS:
 
 	void scaleChanged();
@@ -119,6 +160,67 @@ Q_SIGNALS:
 
 protected:
 
+	/*!
+	 * \brief The ItemSnapshot struct hold a copy of what is needed to paint an item,
+	 * so that the tiles can be painted on a background thread while the template is edited.
+	 */
+	struct ItemSnapshot {
+		AutoQuill::DocumentItem::Type type;
+		AutoQuill::DocumentItem::Direction direction;
+		QPointF pos;
+		QPointF origin;
+		QSizeF size;
+		QString name;
+		QColor borderColor;
+		qreal borderWidth;
+		QColor fillColor;
+		QRectF bounds; //bounds of the item and its subitems, in document units, in the parent coordinates
+		QSizeF labelExtent; //extent of the icons and labels of the item and its subitems, in pixels
+		QVector<ItemSnapshot> subitems;
+	};
+
+	/*!
+	 * \brief The PageThumbnail struct hold a low detail rendering of a page, painted lazily by the tile renderer.
+	 */
+	struct PageThumbnail {
+		QMutex mutex;
+		QImage image;
+	};
+
+	struct PageSnapshot {
+		bool valid;
+		QRectF rect; //page rect, in document coordinates
+		QRectF itemsBounds; //bounds of the items, in document units, relative to the page
+		QSizeF labelExtent;
+		QVector<ItemSnapshot> items;
+		QSharedPointer<PageThumbnail> thumbnail;
+	};
+
+	struct DocumentSnapshot {
+		QVector<PageSnapshot> pages;
+		QVector<QImage> icons; //indexed by item type
+		QFont font;
+	};
+
+	struct TileKey {
+		qreal level;
+		int x;
+		int y;
+
+		inline bool operator==(TileKey const& other) const {
+			return level == other.level and x == other.x and y == other.y;
+		}
+
+		friend inline uint qHash(TileKey const& key, uint seed = 0) {
+			return qHash(key.level, seed) ^ qHash(key.x, seed) ^ (qHash(key.y, seed) << 16);
+		}
+	};
+
+	class TileRenderJob;
+
+	static constexpr int tileSize = 256;
+	static constexpr int iconSize = 30;
+
 	void paintEvent(QPaintEvent *event) override;
 	void keyPressEvent(QKeyEvent *event) override;
 	void inputMethodEvent(QInputMethodEvent *event) override;
@@ -128,16 +230,78 @@ protected:
 	void mouseMoveEvent(QMouseEvent *event) override;
 
 
+    /*!
+     * \brief computeItemSize compute the size an item take in the preview, including its subitems.
+     *
+     * The sizes are cached, and invalidated for an item and its ancestors when its properties change.
+     */
     QSizeF computeItemSize(AutoQuill::DocumentItem* item);
 
-	void paintPage(QPointF offset, int pageId, QPainter& painter);
+	void rebuildSnapshot();
+	ItemSnapshot snapshotItem(AutoQuill::DocumentItem* item);
+	void trackItem(AutoQuill::DocumentItem* item);
+
+	/*!
+	 * \brief invalidatePageTiles drop the cached tiles, at all zoom levels, where a page was or is now painted.
+	 */
+	void invalidatePageTiles(PageSnapshot const& oldPage, PageSnapshot const& newPage);
+	QRectF tileDocRect(TileKey const& key) const;
+
+	void startNextTileJob();
+
+	/*!
+	 * \brief dataPagesNeeded give an upper bound of the number of pages needed to fill the view.
+	 */
+	int dataPagesNeeded() const;
+	void scheduleDataLayout();
+	void layoutData();
+	void paintDataPreview(QPainter& painter);
+
+	Q_INVOKABLE void onTileRendered(qreal level, int x, int y, int generation, QImage image);
+
+	/*!
+	 * \brief paintTile paint a tile of the document at a given scale
+	 * \param snapshot the snapshot of the document
+	 * \param scale the scale (document units per pixel)
+	 * \param tile the tile coordinates (in tiles)
+	 * \return the tile image
+	 *
+	 * This function is thread safe, as it only access the snapshot.
+	 */
+	static QImage paintTile(DocumentSnapshot const& snapshot, qreal scale, QPoint const& tile);
+
+	/*!
+	 * \brief pageThumbnail get the low detail rendering of a page, painting it if needed.
+	 */
+	static QImage pageThumbnail(DocumentSnapshot const& snapshot, PageSnapshot const& page);
+
+	static QRectF pagePaintedRect(PageSnapshot const& page, qreal scale);
+
+	/*!
+	 * \brief paintPage paint a page and its items
+	 * \param exposed the region to paint, in device coordinates, items outside of it are skipped.
+	 */
+	static void paintPage(DocumentSnapshot const& snapshot, PageSnapshot const& page, qreal scale, QPainter& painter, QRectF const& exposed);
     /*!
      * \brief paintItem paint an item on the preview widget
+     * \param snapshot the snapshot of the document (for the icons)
      * \param item the item to paint
+     * \param scale the scale to paint at
      * \param painter the painter to use
-     * \return the offset the item took on the widget (usefull e.g. when painting a list to apply dynamic offset).
+     * \param exposed the region to paint, in device coordinates, the item and its subitems are skipped if they are outside.
      */
-    QSizeF paintItem(AutoQuill::DocumentItem* item, QPainter& painter);
+    static void paintItem(DocumentSnapshot const& snapshot, ItemSnapshot const& item, qreal scale, QPainter& painter, QRectF const& exposed);
+
+	/*!
+	 * \brief lodScaleLevel is the zoom level above which pages are drawn from their low detail thumbnail.
+	 */
+	static const qreal lodScaleLevel;
+
+protected Q_SLOTS:
+
+	void onItemChanged();
+
+protected:
 
 	static const qreal scaleBase;
 	static const qreal scaleLevelMax;
@@ -151,6 +315,33 @@ protected:
 
 	AutoQuill::DocumentTemplate* _documentTemplate;
 
+	QVector<QImage> _icons;
+
+	QSharedPointer<const DocumentSnapshot> _snapshot;
+	int _snapshotGeneration;
+	bool _snapshotDirty;
+	bool _fullInvalidation;
+	QSet<int> _dirtyPages; //root items of the template with modified items since the last snapshot
+	QHash<AutoQuill::DocumentItem const*, QSizeF> _itemSizes;
+
+	QCache<TileKey, QPixmap> _tiles;
+	QList<TileKey> _tileQueue; //visible tiles missing at the current zoom level
+	bool _tileInFlight;
+	TileKey _inFlightTile;
+	QThreadPool _tilePool;
+
+	AutoQuill::JsonDocumentDataInterface* _dataInterface;
+	AutoQuill::RenderPluginManager* _pluginManager;
+	AutoQuill::DocumentRenderer* _dataRenderer;
+	AutoQuill::DocumentLayout _dataLayout;
+	QVector<AutoQuill::ItemRenderInfos*> _dataPages; //pages of _dataLayout
+	QVector<QPointF> _dataPagesOffsets; //pending offsets of the parents of the pages
+	int _dataLayoutMaxPages;
+	QString _dataLayoutError;
+	QHash<int, QImage> _dataPageImages; //rendered pages, at _dataPageImagesScale
+	qreal _dataPageImagesScale;
+	QTimer* _dataLayoutTimer;
+
 private:
 
 	QPoint _motion_origin_pos;
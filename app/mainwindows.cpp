@@ -28,6 +28,8 @@
 #include <QPushButton>
 #include <QFontComboBox>
 #include <QColorDialog>
+#include <QMessageBox>
+#include <QFile>
 
 #include "../lib/documentitem.h"
 #include "../lib/documenttemplate.h"
@@ -59,6 +61,15 @@ MainWindows::MainWindows(QWidget *parent) :
 	connect(openAction, &QAction::triggered, this, &MainWindows::openProject);
     connect(exportAction, &QAction::triggered, this, &MainWindows::exportDocument);
 
+	QMenu* viewMenu = menuBar()->addMenu(tr("view"));
+	QAction* dataPreviewAction = viewMenu->addAction(tr("preview with data"));
+	QAction* templatePreviewAction = viewMenu->addAction(tr("preview template"));
+
+	connect(dataPreviewAction, &QAction::triggered, this, &MainWindows::previewWithData);
+	connect(templatePreviewAction, &QAction::triggered, this, [this] () {
+		_docPreviewWidget->clearPreviewData();
+	});
+
 	//setup dockers
 
 	_projectTreeDockWidget = new QDockWidget(tr("Project tree"), this);
@@ -117,6 +128,12 @@ MainWindows::MainWindows(QWidget *parent) :
 
 	setCentralWidget(_docPreviewWidget);
 
+	//the preview track the items properties itself, but structural changes go through the model.
+	connect(_documentTemplateModel, &QAbstractItemModel::rowsInserted, _docPreviewWidget, &DocumentPreviewWidget::invalidate);
+	connect(_documentTemplateModel, &QAbstractItemModel::rowsRemoved, _docPreviewWidget, &DocumentPreviewWidget::invalidate);
+	connect(_documentTemplateModel, &QAbstractItemModel::rowsMoved, _docPreviewWidget, &DocumentPreviewWidget::invalidate);
+	connect(_documentTemplateModel, &QAbstractItemModel::modelReset, _docPreviewWidget, &DocumentPreviewWidget::invalidate);
+
 	//register the documentTemplate
 	setCurrentDocumentTemplate(documentTemplate);
 
@@ -707,3 +724,40 @@ void MainWindows::exportDocument() {
     exportTemplateUsingJson(_currentDocumentTemplate, this);
 
 }
+
+void MainWindows::previewWithData() {
+
+	QString docFolderPath = QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation).first();
+
+	QString fileName = QFileDialog::getOpenFileName(this,
+													tr("Open json data file"),
+													docFolderPath,
+													tr("Json files (*.json)"));
+
+	if (fileName.isEmpty()) {
+		return;
+	}
+
+	QFile inFile(fileName);
+
+	if (!inFile.open(QFile::ReadOnly)) {
+		QMessageBox::warning(this,
+							 tr("Error loading preview data"),
+							 tr("Could not open file: %1").arg(fileName));
+		return;
+	}
+
+	QJsonParseError parseError;
+	QJsonDocument doc = QJsonDocument::fromJson(inFile.readAll(), &parseError);
+
+	if (parseError.error != QJsonParseError::NoError or !doc.isObject()) {
+		QMessageBox::warning(this,
+							 tr("Error loading preview data"),
+							 tr("Error while parsing json: %1").arg(parseError.error != QJsonParseError::NoError ?
+																		parseError.errorString() :
+																		tr("document is not an object")));
+		return;
+	}
+
+	_docPreviewWidget->setPreviewData(doc.object());
+}
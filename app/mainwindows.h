@@ -47,6 +47,7 @@ protected:
 	void saveProjectAs();
 	void openProject();
     void exportDocument();
+	void previewWithData();
 
 	QDockWidget* _projectTreeDockWidget;
 	QTreeView* _projectTreeViewWidget;
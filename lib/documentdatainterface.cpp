@@ -36,4 +36,8 @@ DocumentDataInterface::DocumentDataInterface(QObject *parent) :
 
 }
 
+QByteArray DocumentDataInterface::contentHash() const {
+	return QByteArray();
+}
+
 } // namespace AutoQuill
@@ -75,6 +75,12 @@ public:
 
 	virtual DocumentValue getValue(QString const& key) const = 0;
 
+	/*!
+	 * \brief contentHash give a hash of the whole data, used to cache the results of a layout.
+	 * \return the hash, or an empty array if the data cannot be hashed (the default), in which case nothing is cached.
+	 */
+	virtual QByteArray contentHash() const;
+
 };
 
 } // namespace AutoQuill
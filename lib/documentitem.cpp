@@ -11,10 +11,13 @@
 #include <QMetaObject>
 #include <QMetaProperty>
 
+#include <QDataStream>
+
 namespace AutoQuill {
 
 DocumentItem::DocumentItem(Type type, QObject *parent) :
     QObject(parent),
+	_rowHint(-1),
 	_type(type),
 	_direction(Top2Bottom)
 {
@@ -372,6 +375,292 @@ DocumentItem* DocumentItem::buildFromJson(QJsonValue const& value) {
 	return item;
 }
 
+namespace {
+
+/*!
+ * \brief The BinaryProperty struct describe how a property is written in the binary template format.
+ *
+ * The id of a property is its index in the binaryProperties table, so new properties have to be appended at the end.
+ * excludedTypes is a mask of (1 << type) for the types which do not store the property,
+ * it has to be kept in sync with DocumentItem::propertyIsStoredForCurrentType.
+ */
+struct BinaryProperty {
+	quint32 excludedTypes;
+	bool requirePage;
+	void (*write)(DocumentItem const* item, QDataStream & out);
+	void (*read)(DocumentItem* item, QDataStream & in);
+};
+
+constexpr quint32 typeBit(DocumentItem::Type type) {
+	return 1u << type;
+}
+
+constexpr quint32 noStyleTypes = typeBit(DocumentItem::Page) |
+		typeBit(DocumentItem::Condition) |
+		typeBit(DocumentItem::Loop) |
+		typeBit(DocumentItem::List) |
+		typeBit(DocumentItem::Plugin) |
+		typeBit(DocumentItem::Image);
+
+constexpr quint32 noFontTypes = noStyleTypes | typeBit(DocumentItem::Frame);
+
+const BinaryProperty binaryProperties[] = {
+	{0, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->objectName(); },
+	 [] (DocumentItem* item, QDataStream & in) { QString v; in >> v; item->setObjectName(v); }},
+	{0, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << quint8(item->direction()); },
+	 [] (DocumentItem* item, QDataStream & in) {
+		quint8 v; in >> v; item->setDirection(static_cast<DocumentItem::Direction>(v)); }},
+	{0, true,
+	 [] (DocumentItem const* item, QDataStream & out) { out << quint8(item->overflowBehavior()); },
+	 [] (DocumentItem* item, QDataStream & in) {
+		quint8 v; in >> v; item->setOverflowBehavior(static_cast<DocumentItem::OverflowBehavior>(v)); }},
+	{0, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << quint8(item->layoutExpandBehavior()); },
+	 [] (DocumentItem* item, QDataStream & in) {
+		quint8 v; in >> v; item->setLayoutExpandBehavior(static_cast<DocumentItem::LayoutExpandBehavior>(v)); }},
+	{0, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << quint8(item->marginsExpandBehavior()); },
+	 [] (DocumentItem* item, QDataStream & in) {
+		quint8 v; in >> v; item->setMarginsExpandBehavior(static_cast<DocumentItem::MarginsExpandBehavior>(v)); }},
+	{typeBit(DocumentItem::Page) | typeBit(DocumentItem::Condition), false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->posX(); },
+	 [] (DocumentItem* item, QDataStream & in) { qreal v; in >> v; item->setPosX(v); }},
+	{typeBit(DocumentItem::Page) | typeBit(DocumentItem::Condition), false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->posY(); },
+	 [] (DocumentItem* item, QDataStream & in) { qreal v; in >> v; item->setPosY(v); }},
+	{0, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->initialWidth(); },
+	 [] (DocumentItem* item, QDataStream & in) { qreal v; in >> v; item->setInitialWidth(v); }},
+	{0, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->initialHeight(); },
+	 [] (DocumentItem* item, QDataStream & in) { qreal v; in >> v; item->setInitialHeight(v); }},
+	{typeBit(DocumentItem::Page), false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->maxWidth(); },
+	 [] (DocumentItem* item, QDataStream & in) { qreal v; in >> v; item->setMaxWidth(v); }},
+	{typeBit(DocumentItem::Page), false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->maxHeight(); },
+	 [] (DocumentItem* item, QDataStream & in) { qreal v; in >> v; item->setMaxHeight(v); }},
+	{noStyleTypes, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->borderWidth(); },
+	 [] (DocumentItem* item, QDataStream & in) { qreal v; in >> v; item->setBorderWidth(v); }},
+	{noStyleTypes, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << quint32(item->borderColor().rgba()); },
+	 [] (DocumentItem* item, QDataStream & in) { quint32 v; in >> v; item->setBorderColor(QColor::fromRgba(v)); }},
+	{noStyleTypes, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << quint32(item->fillColor().rgba()); },
+	 [] (DocumentItem* item, QDataStream & in) { quint32 v; in >> v; item->setFillColor(QColor::fromRgba(v)); }},
+	{noFontTypes, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->fontName(); },
+	 [] (DocumentItem* item, QDataStream & in) { QString v; in >> v; item->setFontName(v); }},
+	{noFontTypes, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->fontSize(); },
+	 [] (DocumentItem* item, QDataStream & in) { qreal v; in >> v; item->setFontSize(v); }},
+	{noFontTypes, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << qint16(item->fontWeight()); },
+	 [] (DocumentItem* item, QDataStream & in) { qint16 v; in >> v; item->setFontWeight(v); }},
+	{noFontTypes, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << quint8(item->textAlign()); },
+	 [] (DocumentItem* item, QDataStream & in) {
+		quint8 v; in >> v; item->setTextAlign(static_cast<DocumentItem::TextAlign>(v)); }},
+	{0, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->dataKey(); },
+	 [] (DocumentItem* item, QDataStream & in) { QString v; in >> v; item->setDataKey(v); }},
+	{0, false,
+	 [] (DocumentItem const* item, QDataStream & out) { out << item->data(); },
+	 [] (DocumentItem* item, QDataStream & in) { QString v; in >> v; item->setData(v); }},
+};
+
+constexpr int nBinaryProperties = sizeof(binaryProperties)/sizeof(BinaryProperty);
+
+inline bool binaryPropertyIsStored(BinaryProperty const& prop, DocumentItem::Type type, bool inPage) {
+
+	if (type == DocumentItem::Invalid) {
+		return false;
+	}
+
+	if (prop.requirePage and !inPage) {
+		return false;
+	}
+
+	return (prop.excludedTypes & typeBit(type)) == 0;
+}
+
+void writeItemToBinary(DocumentItem const* item, QDataStream & out, bool inPage) {
+
+	DocumentItem::Type type = item->getType();
+
+	quint8 nProps = 0;
+
+	for (BinaryProperty const& prop : binaryProperties) {
+		if (binaryPropertyIsStored(prop, type, inPage)) {
+			nProps++;
+		}
+	}
+
+	out << quint8(type) << nProps;
+
+	for (int i = 0; i < nBinaryProperties; i++) {
+		if (binaryPropertyIsStored(binaryProperties[i], type, inPage)) {
+			out << quint8(i);
+			binaryProperties[i].write(item, out);
+		}
+	}
+
+	bool subitemsInPage = inPage or type == DocumentItem::Page;
+
+	QList<DocumentItem*> const& subitems = item->subitems();
+
+	quint32 nSubitems = 0;
+
+	for (DocumentItem* subitem : subitems) {
+		if (subitem != nullptr) {
+			nSubitems++;
+		}
+	}
+
+	out << nSubitems;
+
+	for (DocumentItem* subitem : subitems) {
+		if (subitem == nullptr) {
+			continue;
+		}
+
+		writeItemToBinary(subitem, out, subitemsInPage);
+	}
+}
+
+} // namespace
+
+void DocumentItem::encapsulateToBinary(QDataStream & out) const {
+	writeItemToBinary(this, out, const_cast<DocumentItem*>(this)->parentPage() != nullptr);
+}
+
+DocumentItem* DocumentItem::buildFromBinary(QDataStream & in) {
+
+	quint8 typeId;
+	quint8 nProps;
+
+	in >> typeId >> nProps;
+
+	if (in.status() != QDataStream::Ok) {
+		return nullptr;
+	}
+
+	Type type = (typeId < Invalid) ? static_cast<Type>(typeId) : Invalid;
+
+	//invalid items are still read to consume their data, but are discarded afterward.
+	DocumentItem* item = new DocumentItem(type);
+
+	for (int i = 0; i < nProps; i++) {
+		quint8 id;
+		in >> id;
+
+		if (in.status() != QDataStream::Ok) {
+			break;
+		}
+
+		if (id >= nBinaryProperties) {
+			in.setStatus(QDataStream::ReadCorruptData);
+			break;
+		}
+
+		binaryProperties[id].read(item, in);
+	}
+
+	quint32 nSubitems = 0;
+	in >> nSubitems;
+
+	for (quint32 i = 0; i < nSubitems and in.status() == QDataStream::Ok; i++) {
+
+		DocumentItem* subitem = DocumentItem::buildFromBinary(in);
+
+		if (subitem == nullptr) {
+			continue;
+		}
+
+		item->insertSubItem(subitem);
+	}
+
+	if (type == Invalid or in.status() != QDataStream::Ok) {
+		delete item;
+		return nullptr;
+	}
+
+	return item;
+}
+
+bool DocumentItem::removeSubItem(int index) {
+	if (index < 0 or index >= _items.size()) {
+		return false;
+	}
+
+	DocumentTemplate* pTemplate = parentTemplate();
+
+	if (pTemplate != nullptr and _items[index] != nullptr) {
+		pTemplate->unindexReferences(_items[index]);
+	}
+
+	_items.removeAt(index);
+	return true;
+}
+
+int DocumentItem::row() const {
+
+	QList<DocumentItem*> const* siblings = nullptr;
+
+	DocumentItem* pItem = qobject_cast<DocumentItem*>(parent());
+
+	if (pItem != nullptr) {
+		siblings = &pItem->_items;
+	} else {
+		DocumentTemplate* pTemplate = qobject_cast<DocumentTemplate*>(parent());
+
+		if (pTemplate == nullptr) {
+			return -1;
+		}
+
+		siblings = &pTemplate->_items;
+	}
+
+	if (_rowHint >= 0 and _rowHint < siblings->size() and siblings->at(_rowHint) == this) {
+		return _rowHint;
+	}
+
+	//the siblings list has been modified since the hint was set, refresh all the hints at once.
+	int ret = -1;
+
+	for (int i = 0; i < siblings->size(); i++) {
+		DocumentItem* sibling = siblings->at(i);
+
+		if (sibling == nullptr) {
+			continue;
+		}
+
+		sibling->_rowHint = i;
+
+		if (sibling == this) {
+			ret = i;
+		}
+	}
+
+	return ret;
+}
+
+DocumentTemplate* DocumentItem::parentTemplate() {
+
+	DocumentItem* root = this;
+	DocumentItem* pItem = parentDocumentItem();
+
+	while (pItem != nullptr) {
+		root = pItem;
+		pItem = pItem->parentDocumentItem();
+	}
+
+	return qobject_cast<DocumentTemplate*>(root->parent());
+}
+
 QString DocumentItem::buildRef() {
 
 	QStringList refsList;
@@ -406,7 +695,15 @@ QString DocumentItem::buildRef() {
 			_ref = QString("%1").arg(r_n);
 		}
 
-		return parentRef + DocumentTemplate::REF_URL_SEP + _ref;
+		QString ref = parentRef + DocumentTemplate::REF_URL_SEP + _ref;
+
+		DocumentTemplate* pTemplate = parentTemplate();
+
+		if (pTemplate != nullptr) {
+			pTemplate->indexReference(ref, this);
+		}
+
+		return ref;
 	}
 
 	DocumentTemplate* pTemplate = qobject_cast<DocumentTemplate*>(parent());
@@ -439,6 +736,8 @@ QString DocumentItem::buildRef() {
 		_ref = QString("%1").arg(r_n);
 	}
 
+	pTemplate->indexReference(_ref, this);
+
 	return _ref;
 }
 
@@ -6,8 +6,12 @@
 #include <QPoint>
 #include <QSize>
 
+class QDataStream;
+
 namespace AutoQuill {
 
+class DocumentTemplate;
+
 class DocumentItem : public QObject
 {
     Q_OBJECT
@@ -490,7 +494,7 @@ public:
 
 	}
 
-    inline QString dataKey() {
+    inline QString dataKey() const {
         return _data_key;
     }
 
@@ -501,7 +505,7 @@ public:
         }
     }
 
-    inline QString data() {
+    inline QString data() const {
         return _data;
     }
 
@@ -512,14 +516,7 @@ public:
         }
 	}
 
-	inline bool removeSubItem(int index) {
-		if (index < 0 or index >= _items.size()) {
-			return false;
-		}
-
-		_items.removeAt(index);
-		return true;
-	}
+	bool removeSubItem(int index);
 
 	inline bool moveSubItem(int previousIndex, int newIndex) {
 		if (previousIndex < 0 or newIndex < 0 or previousIndex >= _items.size() or newIndex >= _items.size()) {
@@ -533,6 +530,11 @@ public:
 	inline DocumentItem* parentDocumentItem() {
 		return qobject_cast<DocumentItem*>(parent());
 	}
+	/*!
+	 * \brief parentTemplate get the template the item belongs to
+	 * \return the template, or nullptr if the item is not part of a template.
+	 */
+	DocumentTemplate* parentTemplate();
 	inline DocumentItem* parentPage() {
 
 		DocumentItem* pItem = parentDocumentItem();
@@ -584,6 +586,14 @@ public:
 
 	int pageId();
 
+	/*!
+	 * \brief row get the position of the item in its parent subitems (or in the template for root items).
+	 * \return the row, or -1 if the item is not in its parent subitems.
+	 *
+	 * The row is cached and checked in constant time, the cache is refreshed for all siblings when they are modified.
+	 */
+	int row() const;
+
 	inline QPointF origin() const {
 		switch(_direction) {
 		case Left2Right:
@@ -611,6 +621,21 @@ public:
     QJsonValue encapsulateToJson() const;
 	static DocumentItem* buildFromJson(QJsonValue const& value);
 
+	/*!
+	 * \brief encapsulateToBinary write the item and its subitems in the binary template format.
+	 * \param out the stream to write to.
+	 *
+	 * The binary format stores the same properties as the json format, but uses a fixed table
+	 * of properties identified by a small id instead of going through the meta object system.
+	 */
+	void encapsulateToBinary(QDataStream & out) const;
+	/*!
+	 * \brief buildFromBinary read an item written by encapsulateToBinary.
+	 * \param in the stream to read from.
+	 * \return the item, or nullptr if the data was invalid (the stream status is then set accordingly).
+	 */
+	static DocumentItem* buildFromBinary(QDataStream & in);
+
 	/*!
 	 * \brief buildRef build a reference which allows to find the object later
 	 * \return the reference as a string.
@@ -662,6 +687,7 @@ protected:
     bool propertyIsStoredForCurrentType(const char* propName) const;
 
 	QString _ref;
+	mutable int _rowHint;
 
     Type _type;
 
@@ -694,6 +720,7 @@ protected:
 
 	QList<DocumentItem*> _items;
 
+	friend class DocumentTemplate;
 	friend class DocumentTemplateModel;
 };
 
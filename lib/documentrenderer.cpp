@@ -3,29 +3,749 @@
 #include <QObject>
 
 #include <QPdfWriter>
-#include <QSvgRenderer>
 #include <QPainter>
 #include <QFile>
 #include <QFontMetricsF>
 #include <QTextLayout>
+#include <QPicture>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QMutexLocker>
+#include <QImage>
+#include <QImageWriter>
+#include <QDataStream>
+#include <QBuffer>
+#include <QElapsedTimer>
+
+#include <cmath>
+#include <algorithm>
+#include <ctime>
 
 #include "documenttemplate.h"
 #include "documentitem.h"
 #include "documentdatainterface.h"
 #include "renderplugin.h"
+#include "layoutcache.h"
+#include "outputcache.h"
+#include "recordingdatainterface.h"
 
 namespace AutoQuill {
 
+/*!
+ * \brief callPluginRender render a plugin item, using the data prepared during layout if the plugin support it.
+ */
+static DocumentRenderer::RenderingStatus callPluginRender(RenderPlugin const* plugin,
+														  QRectF const& area,
+														  QPainter & painter,
+														  DocumentValue const& value,
+														  QSharedPointer<const PluginPreparedData> const& prepared) {
+
+	PreparedRenderPlugin const* preparedPlugin = dynamic_cast<PreparedRenderPlugin const*>(plugin);
+
+	if (preparedPlugin != nullptr and !prepared.isNull()) {
+		return preparedPlugin->renderPreparedItem(area, painter, prepared.data());
+	}
+
+	return plugin->renderItem(area, painter, value);
+}
+
+namespace {
+
+//memory used by a layout item, including its slot in the parent's list of subitems.
+constexpr qint64 layoutNodeBytes = sizeof(ItemRenderInfos) + sizeof(ItemRenderInfos*);
+
+/*!
+ * \brief The RenderOffsetScope class add the pending offset of an item to the render offset while its subitems are drawn.
+ */
+class RenderOffsetScope {
+public:
+	RenderOffsetScope(QPointF & renderOffset, QPointF const& subitemsOffset) :
+		_renderOffset(renderOffset),
+		_previous(renderOffset)
+	{
+		_renderOffset += subitemsOffset;
+	}
+
+	~RenderOffsetScope() {
+		_renderOffset = _previous;
+	}
+
+private:
+	QPointF & _renderOffset;
+	QPointF _previous;
+};
+
+qint64 countLayoutNodes(QVector<ItemRenderInfos*> const& items) {
+
+	qint64 count = 0;
+
+	for (ItemRenderInfos* itemInfos : items) {
+		if (itemInfos != nullptr) {
+			count += 1 + countLayoutNodes(itemInfos->subitemsRenderInfos);
+		}
+	}
+
+	return count;
+}
+
+//move the pages out of a layout subtree, the parents of the pages (loops and conditions) do not paint anything themselves.
+void detachLayoutPages(ItemRenderInfos* itemInfos, QVector<ItemRenderInfos*> & pages) {
+
+	for (ItemRenderInfos* & subItemInfos : itemInfos->subitemsRenderInfos) {
+		if (subItemInfos == nullptr or subItemInfos->item == nullptr) {
+			continue;
+		}
+
+		if (subItemInfos->item->getType() == DocumentItem::Page) {
+			if (subItemInfos->toRender) {
+				pages.push_back(subItemInfos);
+			} else {
+				delete subItemInfos;
+			}
+			subItemInfos = nullptr;
+		} else {
+			detachLayoutPages(subItemInfos, pages);
+		}
+	}
+}
+
+/*!
+ * \brief The PhaseTimer class add the wall and cpu time elapsed until it is stopped (or destroyed) to a pair of counters.
+ */
+class PhaseTimer
+{
+public:
+	PhaseTimer(qint64 & wallNs, qint64 & cpuNs) :
+		_wallNs(wallNs),
+		_cpuNs(cpuNs),
+		_cpuStart(std::clock()),
+		_running(true)
+	{
+		_timer.start();
+	}
+
+	~PhaseTimer() {
+		stop();
+	}
+
+	void stop() {
+		if (!_running) {
+			return;
+		}
+		_running = false;
+		_wallNs += _timer.nsecsElapsed();
+		_cpuNs += static_cast<qint64>(static_cast<double>(std::clock() - _cpuStart) * (1e9/CLOCKS_PER_SEC));
+	}
+
+protected:
+	qint64 & _wallNs;
+	qint64 & _cpuNs;
+	QElapsedTimer _timer;
+	std::clock_t _cpuStart;
+	bool _running;
+};
+
+/*!
+ * \brief The CountingDevice class forward the data written to another device, counting the bytes.
+ *
+ * The target device is opened if needed, and then closed along with the CountingDevice, as a QPdfWriter would do.
+ */
+class CountingDevice : public QIODevice
+{
+public:
+	explicit CountingDevice(QIODevice* target) :
+		_target(target),
+		_count(0),
+		_closeTarget(false)
+	{
+		if (_target != nullptr and !_target->isOpen()) {
+			_closeTarget = _target->open(QIODevice::WriteOnly);
+		}
+		open(QIODevice::WriteOnly);
+	}
+
+	~CountingDevice() {
+		if (_closeTarget) {
+			_target->close();
+		}
+	}
+
+	inline qint64 count() const {
+		return _count;
+	}
+
+	bool isSequential() const override {
+		return true;
+	}
+
+protected:
+
+	qint64 readData(char* data, qint64 maxlen) override {
+		Q_UNUSED(data);
+		Q_UNUSED(maxlen);
+		return -1;
+	}
+
+	qint64 writeData(const char* data, qint64 len) override {
+
+		if (_target == nullptr) {
+			return -1;
+		}
+
+		qint64 written = _target->write(data, len);
+
+		if (written > 0) {
+			_count += written;
+		}
+
+		return written;
+	}
+
+	QIODevice* _target;
+	qint64 _count;
+	bool _closeTarget;
+};
+
+/*!
+ * \brief The PluginPicture class record a plugin drawing with the resolution of the device it is replayed on.
+ *
+ * A QPicture reports the default resolution, so fonts would be measured differently than on the target device.
+ */
+class PluginPicture : public QPicture
+{
+public:
+	PluginPicture() :
+		_dpiX(0),
+		_dpiY(0)
+	{
+
+	}
+
+	void setResolution(int dpiX, int dpiY) {
+		_dpiX = dpiX;
+		_dpiY = dpiY;
+	}
+
+protected:
+	int metric(PaintDeviceMetric metric) const override {
+
+		switch (metric) {
+		case PdmDpiX:
+		case PdmPhysicalDpiX:
+			if (_dpiX > 0) {
+				return _dpiX;
+			}
+			break;
+		case PdmDpiY:
+		case PdmPhysicalDpiY:
+			if (_dpiY > 0) {
+				return _dpiY;
+			}
+			break;
+		default:
+			break;
+		}
+
+		return QPicture::metric(metric);
+	}
+
+	int _dpiX;
+	int _dpiY;
+};
+
+} // namespace
+
+class DocumentRenderer::PluginRenderJob : public QRunnable
+{
+public:
+	PluginRenderJob(RenderPlugin const* plugin,
+					QRectF const& area,
+					DocumentValue const& value,
+					QSharedPointer<const PluginPreparedData> const& prepared,
+					RenderTracer* tracer,
+					DocumentItem const* item,
+					int page,
+					QPainter const* target) :
+		_plugin(plugin),
+		_area(area),
+		_value(value),
+		_prepared(prepared),
+		_tracer(tracer),
+		_item(item),
+		_page(page),
+		_renderHints(target->renderHints())
+	{
+		setAutoDelete(false);
+
+		//the plugin should draw as it would on the target painter, the clip is applied when the picture is replayed.
+		if (target->device() != nullptr) {
+			_picture.setResolution(target->device()->logicalDpiX(), target->device()->logicalDpiY());
+		}
+	}
+
+	void run() override {
+		{
+			RenderTracer::Scope traceScope(_tracer, "render", _item, _page);
+
+			QPainter painter(&_picture);
+			painter.setRenderHints(_renderHints);
+			_status = callPluginRender(_plugin, _area, painter, _value, _prepared);
+			painter.end();
+		}
+
+		_done.release();
+	}
+
+	void waitForDone() {
+		_done.acquire();
+		_done.release();
+	}
+
+	QPicture const& picture() const {
+		return _picture;
+	}
+
+	RenderingStatus const& status() const {
+		return _status;
+	}
+
+protected:
+	RenderPlugin const* _plugin;
+	QRectF _area;
+	DocumentValue _value;
+	QSharedPointer<const PluginPreparedData> _prepared;
+
+	RenderTracer* _tracer;
+	DocumentItem const* _item;
+	int _page;
+	QPainter::RenderHints _renderHints;
+
+	PluginPicture _picture;
+	RenderingStatus _status;
+	QSemaphore _done;
+};
+
+class DocumentRenderer::PageRasterJob : public QRunnable
+{
+public:
+	PageRasterJob(DocumentRenderer const* parent,
+				  ItemRenderInfos* page,
+				  QPointF const& parentsOffset,
+				  int pageIndex,
+				  QString const& fileName,
+				  qreal dpi,
+				  QByteArray const& format,
+				  RenderingStatus* status,
+				  RenderStatistics* statistics) :
+		_parent(parent),
+		_page(page),
+		_parentsOffset(parentsOffset),
+		_pageIndex(pageIndex),
+		_fileName(fileName),
+		_dpi(dpi),
+		_format(format),
+		_status(status),
+		_statistics(statistics)
+	{
+
+	}
+
+	void run() override {
+
+		qreal scale = _dpi/72.;
+
+		QSize imageSize(std::ceil(_page->currentSize.width()*scale),
+						std::ceil(_page->currentSize.height()*scale));
+
+		if (imageSize.isEmpty()) {
+			*_status = RenderingStatus{OtherError, QObject::tr("Empty page: %1").arg(_page->item->objectName())};
+			return;
+		}
+
+		QImage image(imageSize, QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::white);
+
+		//the layout is done in points, at 72 dpi, ensure the fonts are measured the same way.
+		int dotsPerMeter = qRound(72/0.0254);
+		image.setDotsPerMeterX(dotsPerMeter);
+		image.setDotsPerMeterY(dotsPerMeter);
+
+		QPainter painter(&image);
+		painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+		painter.scale(scale, scale);
+		painter.translate(-(_page->currentOrigin + _parentsOffset));
+
+		//each worker get its own renderer, as the renderer state is tied to its painter.
+		DocumentRenderer renderer(*_parent->_docTemplate, _parent->_imagePrefetcher);
+		renderer._pluginManager = _parent->_pluginManager;
+		renderer._pluginPool = _parent->_pluginPool;
+		renderer._tracer = _parent->_tracer;
+		renderer._pagesWritten = _pageIndex; //only used to number the pages, as there is no writer
+
+		*_status = renderer.renderItemToExternalPainter(*_page, &painter, _parentsOffset);
+		painter.end();
+
+		*_statistics = renderer._statistics;
+
+		QImageWriter writer(_fileName, _format);
+
+		if (writer.write(image)) {
+			_statistics->pagesProduced = 1;
+			_statistics->bytesWritten = writer.device()->size(); //the size of a file device also flush it
+		} else {
+			renderer.reportDiagnostic(OtherError, _page->item, _pageIndex, QT_TR_NOOP("Could not write the image of %1 to %2: %3"),
+									  QVariantList{_fileName, writer.errorString()});
+
+			if (_status->status == Success) {
+				_status->status = OtherError;
+			}
+		}
+
+		renderer.attachResults(*_status);
+	}
+
+protected:
+	DocumentRenderer const* _parent;
+	ItemRenderInfos* _page;
+	QPointF _parentsOffset;
+	int _pageIndex;
+	QString _fileName;
+	qreal _dpi;
+	QByteArray _format;
+	RenderingStatus* _status;
+	RenderStatistics* _statistics;
+};
+
+DocumentLayout::DocumentLayout() :
+	_data(new Data())
+{
+
+}
+
+DocumentLayout::DocumentLayout(QVector<ItemRenderInfos*> const& items) :
+	_data(new Data())
+{
+	_data->items = items;
+}
+
+DocumentLayout::Data::~Data() {
+	for (ItemRenderInfos* item : qAsConst(items)) {
+		if (item != nullptr) {
+			delete item;
+		}
+	}
+}
+
+constexpr quint32 DocumentLayout::BinaryMagic;
+constexpr quint16 DocumentLayout::BinaryVersion;
+
+namespace {
+
+enum LayoutNodeFlag : quint8 {
+	NodeValid = 1,
+	NodeToRender = 2,
+	NodeRendered = 4,
+	NodeHasValue = 8
+};
+
+/*!
+ * \brief writeLayoutNode write a layout item and its subitems, the item of the node is written as its row in its parent.
+ */
+void writeLayoutNode(QDataStream & out, ItemRenderInfos const* node) {
+
+	if (node == nullptr) {
+		out << quint8(0);
+		return;
+	}
+
+	quint8 flags = NodeValid;
+	QVariant value;
+
+	if (node->toRender) {
+		flags |= NodeToRender;
+	}
+
+	if (node->rendered) {
+		flags |= NodeRendered;
+	}
+
+	if (node->itemValue.hasData()) {
+		flags |= NodeHasValue;
+		value = node->itemValue.getValue();
+	}
+
+	out << flags;
+	out << qint32((node->item != nullptr) ? node->item->row() : -1);
+	out << node->currentOrigin << node->subitemsOffset << node->currentSize << node->maxSize;
+	out << quint8(node->layoutStatus);
+	out << node->continuationIndex;
+
+	if (flags & NodeHasValue) {
+		out << value;
+	}
+
+	out << quint32(node->subitemsRenderInfos.size());
+
+	for (ItemRenderInfos const* subitem : node->subitemsRenderInfos) {
+		writeLayoutNode(out, subitem);
+	}
+}
+
+/*!
+ * \brief isSerializableNode tell if writeLayoutNode can write a layout item and its subitems without loss.
+ *
+ * Containers hand the entries of their structured value to their subitems during the layout, so only the values of
+ * the items rendered from their value matter. Plugins get the whole value and may have prepared data, they are never serializable.
+ */
+bool isSerializableNode(ItemRenderInfos const* node) {
+
+	if (node == nullptr) {
+		return true;
+	}
+
+	if (!node->pluginPreparedData.isNull()) {
+		return false;
+	}
+
+	if (node->item != nullptr) {
+		switch (node->item->getType()) {
+		case DocumentItem::Plugin:
+			return false;
+		case DocumentItem::Text:
+		case DocumentItem::Image:
+			if (node->itemValue.hasArray() or node->itemValue.hasMap()) {
+				return false;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	//custom types cannot be written by QDataStream
+	if (node->itemValue.hasData() and node->itemValue.getValue().userType() >= QMetaType::User) {
+		return false;
+	}
+
+	if (node->continuationIndex.userType() >= QMetaType::User) {
+		return false;
+	}
+
+	for (ItemRenderInfos const* subitem : node->subitemsRenderInfos) {
+		if (!isSerializableNode(subitem)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * \brief readLayoutNode read a layout item written by writeLayoutNode
+ * \param in the stream to read from
+ * \param candidates the items the node can refer to (the subitems of the parent item).
+ * \param version the version of the encoding.
+ * \param ok set to false if the data is invalid.
+ * \return the node, or nullptr for null nodes and errors.
+ */
+ItemRenderInfos* readLayoutNode(QDataStream & in, QList<DocumentItem*> const& candidates, quint16 version, bool & ok) {
+
+	quint8 flags = 0;
+	in >> flags;
+
+	if (!(flags & NodeValid)) {
+		return nullptr;
+	}
+
+	qint32 row = -1;
+	quint8 layoutStatus = 0;
+	quint32 nSubitems = 0;
+
+	ItemRenderInfos* node = new ItemRenderInfos();
+
+	in >> row;
+	in >> node->currentOrigin;
+
+	if (version >= 2) { //version 1 layouts store the actual positions
+		in >> node->subitemsOffset;
+	}
+
+	in >> node->currentSize >> node->maxSize;
+	in >> layoutStatus;
+	in >> node->continuationIndex;
+
+	if (row >= candidates.size()) { //the layout is for another template
+		ok = false;
+	}
+
+	node->item = (row >= 0 and row < candidates.size()) ? candidates[row] : nullptr;
+	node->layoutStatus = static_cast<DocumentRenderer::Status>(layoutStatus);
+	node->renderStatus = DocumentRenderer::Success;
+	node->toRender = flags & NodeToRender;
+	node->rendered = flags & NodeRendered;
+
+	if (flags & NodeHasValue) {
+		QVariant value;
+		in >> value;
+		node->itemValue = DocumentValue([value] () -> QVariant {
+			return value;
+		});
+	}
+
+	in >> nSubitems;
+
+	static const QList<DocumentItem*> noItems;
+	QList<DocumentItem*> const& subCandidates = (node->item != nullptr) ? node->item->subitems() : noItems;
+
+	for (quint32 i = 0; i < nSubitems and ok and in.status() == QDataStream::Ok; i++) {
+		node->subitemsRenderInfos.push_back(readLayoutNode(in, subCandidates, version, ok));
+	}
+
+	return node;
+}
+
+} // namespace
+
+QByteArray DocumentLayout::encapsulateToBinary() const {
+
+	QByteArray datas;
+	QDataStream out(&datas, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_0);
+	out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+	out << BinaryMagic << BinaryVersion;
+	out << qint32(DocumentRenderer::getLayoutNPages(_data->items));
+	out << quint32(_data->items.size());
+
+	for (ItemRenderInfos const* item : qAsConst(_data->items)) {
+		writeLayoutNode(out, item);
+	}
+
+	return datas;
+}
+
+bool DocumentLayout::isSerializable() const {
+
+	for (ItemRenderInfos const* item : qAsConst(_data->items)) {
+		if (!isSerializableNode(item)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool DocumentLayout::configureFromBinary(QByteArray const& data, DocumentTemplate const& docTemplate) {
+
+	QDataStream in(data);
+	in.setVersion(QDataStream::Qt_5_0);
+	in.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+	quint32 magic = 0;
+	quint16 version = 0;
+	qint32 nPages = 0;
+	quint32 nItems = 0;
+
+	in >> magic >> version >> nPages >> nItems;
+
+	_data = QSharedPointer<Data>(new Data());
+
+	if (in.status() != QDataStream::Ok or magic != BinaryMagic or version > BinaryVersion) {
+		return false;
+	}
+
+	bool ok = true;
+
+	for (quint32 i = 0; i < nItems and ok and in.status() == QDataStream::Ok; i++) {
+		_data->items.push_back(readLayoutNode(in, docTemplate.subitems(), version, ok));
+	}
+
+	if (!ok or in.status() != QDataStream::Ok or DocumentRenderer::getLayoutNPages(_data->items) != nPages) {
+		_data = QSharedPointer<Data>(new Data());
+		return false;
+	}
+
+	return true;
+}
+
+DocumentRenderer::RenderStatistics::RenderStatistics() :
+	nodesAllocated(0),
+	paragraphsShaped(0),
+	linesBroken(0),
+	imagesDecoded(0),
+	imageBytesRead(0),
+	pluginCalls(0),
+	pagesProduced(0),
+	bytesWritten(0),
+	peakMemoryBytes(0),
+	layoutCacheHits(0),
+	outputCacheHits(0),
+	layoutWallNs(0),
+	layoutCpuNs(0),
+	renderWallNs(0),
+	renderCpuNs(0)
+{
+
+}
+
+DocumentRenderer::RenderStatistics& DocumentRenderer::RenderStatistics::operator+=(RenderStatistics const& other) {
+	nodesAllocated += other.nodesAllocated;
+	paragraphsShaped += other.paragraphsShaped;
+	linesBroken += other.linesBroken;
+	imagesDecoded += other.imagesDecoded;
+	imageBytesRead += other.imageBytesRead;
+	pluginCalls += other.pluginCalls;
+	pagesProduced += other.pagesProduced;
+	bytesWritten += other.bytesWritten;
+	peakMemoryBytes = std::max(peakMemoryBytes, other.peakMemoryBytes);
+	layoutCacheHits += other.layoutCacheHits;
+	outputCacheHits += other.outputCacheHits;
+	layoutWallNs += other.layoutWallNs;
+	layoutCpuNs += other.layoutCpuNs;
+	renderWallNs += other.renderWallNs;
+	renderCpuNs += other.renderCpuNs;
+	return *this;
+}
+
 DocumentRenderer::DocumentRenderer(const DocumentTemplate &docTemplate) :
+	DocumentRenderer(docTemplate, QSharedPointer<ImagePrefetcher>(new ImagePrefetcher()))
+{
+
+}
+
+DocumentRenderer::DocumentRenderer(DocumentTemplate const& docTemplate, QSharedPointer<ImagePrefetcher> const& imagePrefetcher) :
 	_docTemplate(&docTemplate),
 	_writer(nullptr),
-	_painter(nullptr)
+	_painter(nullptr),
+	_pagesWritten(0),
+	_pagesToWrite(0),
+	_maxPages(-1),
+	_firstPageToRender(0),
+	_movedRowMeasurements(nullptr),
+	_loopDepth(0),
+	_imagePrefetcher(imagePrefetcher),
+	_tracer(nullptr),
+	_layoutCache(nullptr),
+	_outputCache(nullptr),
+	_memoryBudget(-1),
+	_liveNodes(0),
+	_peakLiveNodes(0)
 {
-
+	_cursor.dataInterface = nullptr;
+	_cursor.pluginManager = nullptr;
+	_cursor.painter = nullptr;
+	_cursor.nextItem = 0;
+	_cursor.pageHasMore = false;
+	_cursor.nPages = 0;
+	_cursor.statistics = RenderStatistics();
 }
 
 DocumentRenderer::~DocumentRenderer() {
 
+	collectPluginRenders();
+	endLayout();
+
 	if (_painter != nullptr) {
 		delete _painter;
 		_painter = nullptr;
@@ -34,34 +754,64 @@ DocumentRenderer::~DocumentRenderer() {
 		delete _writer;
 		_writer = nullptr;
 	}
+
 }
 
-DocumentRenderer::LayoutResults DocumentRenderer::layout(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager) {
+DocumentRenderer::LayoutResults DocumentRenderer::layout(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, int maxPages) {
 
 	_pluginManager = &pluginManager;
+	_statistics = RenderStatistics();
+	_diagnostics.clear();
+	_movedDiagnostics.clear();
+
+	QByteArray cacheKey = layoutCacheKey(dataInterface, maxPages);
+
+	if (!cacheKey.isEmpty()) {
+		DocumentLayout cached;
+
+		if (_layoutCache->load(cacheKey, *_docTemplate, cached)) {
+			_statistics.layoutCacheHits++;
+			_statistics.pagesProduced = getLayoutNPages(cached.items());
+
+			RenderingStatus cachedStatus{Success};
+			attachResults(cachedStatus);
+
+			return {cached, cachedStatus, _statistics};
+		}
+	}
 
 	QVector<ItemRenderInfos*> layout;
 
+	_maxPages = maxPages;
+	PhaseTimer layoutTimer(_statistics.layoutWallNs, _statistics.layoutCpuNs);
 	RenderingStatus layoutStatus = layoutDocument(layout, dataInterface);
+	layoutTimer.stop();
+	_maxPages = -1;
 
-	if (layoutStatus.status != Success) {
-		for (ItemRenderInfos* item : qAsConst(layout)) {
-			if (item != nullptr) {
-				delete item;
-			}
-		}
+	addImageStatistics(ImagePrefetcher::Statistics{0, 0, 0, 0, 0, 0}); //the layout reset the prefetcher statistics
+	updatePeakMemory(_peakLiveNodes);
+	_statistics.pagesProduced = _pagesToWrite;
+	attachResults(layoutStatus);
 
-        return {QVector<ItemRenderInfos*>(), layoutStatus};
+	DocumentLayout results(layout); //take ownership of the items, including in case of failure.
+
+	if (layoutStatus.status != Success) {
+        return {DocumentLayout(), layoutStatus, _statistics};
     }
 
-    return {layout, layoutStatus};
+	if (!cacheKey.isEmpty()) {
+		_layoutCache->store(cacheKey, results);
+	}
+
+    return {results, layoutStatus, _statistics};
 }
 DocumentRenderer::LayoutResults DocumentRenderer::layoutHeadless(DocumentDataInterface const* dataInterface,
                                                                  RenderPluginManager const& pluginManager,
-                                                                 QPainter* painterOverride) {
+                                                                 QPainter* painterOverride,
+                                                                 int maxPages) {
     if (painterOverride == nullptr) {
         RenderingStatus layoutStatus{OtherError, "Invalid external painter provided", QSizeF()};
-        return {QVector<ItemRenderInfos*>(), layoutStatus};
+        return {DocumentLayout(), layoutStatus};
     }
 
     QPainter* oldPainter = _painter;
@@ -70,7 +820,7 @@ DocumentRenderer::LayoutResults DocumentRenderer::layoutHeadless(DocumentDataInt
     _painter = painterOverride;
     _writer = nullptr; //no writer means pageless mode
 
-    LayoutResults results = layout(dataInterface, pluginManager);
+    LayoutResults results = layout(dataInterface, pluginManager, maxPages);
 
     _painter = oldPainter;
     _writer = oldWriter;
@@ -80,6 +830,190 @@ DocumentRenderer::LayoutResults DocumentRenderer::layoutHeadless(DocumentDataInt
 
 }
 
+DocumentRenderer::RenderingStatus DocumentRenderer::beginLayout(DocumentDataInterface const* dataInterface,
+																RenderPluginManager const& pluginManager,
+																QPainter* painterOverride) {
+
+	endLayout();
+
+	if (dataInterface == nullptr) {
+		return RenderingStatus{MissingData, QObject::tr("Missing data interface")};
+	}
+
+	if (_docTemplate == nullptr) {
+		return RenderingStatus{MissingModel, QObject::tr("Invalid template")};
+	}
+
+	if (painterOverride == nullptr) {
+		return RenderingStatus{OtherError, QObject::tr("Invalid external painter provided")};
+	}
+
+	_pluginManager = &pluginManager;
+	_statistics = RenderStatistics();
+	_diagnostics.clear();
+	_movedDiagnostics.clear();
+
+	//same state as layoutDocument
+	_imagePrefetcher->clear();
+	_imagePrefetcher->resetStatistics();
+	_rowTextMeasurements.clear();
+	_movedRowMeasurements = nullptr;
+	_loopDepth = 0;
+
+	_pagesToWrite = 0;
+	_liveNodes = 0;
+	_peakLiveNodes = 0;
+
+	_cursor.dataInterface = dataInterface;
+	_cursor.pluginManager = &pluginManager;
+	_cursor.painter = painterOverride;
+	_cursor.nextItem = 0;
+	_cursor.currentPage = DocumentLayout();
+	_cursor.pageHasMore = false;
+	_cursor.nPages = 0;
+	_cursor.statistics = RenderStatistics();
+	_cursor.movedDiagnostics.clear();
+
+	return RenderingStatus{Success};
+}
+
+DocumentRenderer::LayoutResults DocumentRenderer::nextPage() {
+
+	if (_cursor.dataInterface == nullptr) {
+		return {DocumentLayout(), RenderingStatus{OtherError, QObject::tr("No layout in progress, call beginLayout first")}, _statistics};
+	}
+
+	QPainter* oldPainter = _painter;
+	QPdfWriter* oldWriter = _writer;
+
+	_painter = _cursor.painter;
+	_writer = nullptr; //no writer means pageless mode
+
+	//the pages might have been rendered with this renderer since the last call.
+	_pluginManager = _cursor.pluginManager;
+	_statistics = _cursor.statistics;
+	_diagnostics.clear();
+	_movedDiagnostics = _cursor.movedDiagnostics;
+	_pagesToWrite = _cursor.nPages;
+
+	PhaseTimer layoutTimer(_statistics.layoutWallNs, _statistics.layoutCpuNs);
+
+	RenderingStatus status{Success};
+	DocumentLayout page;
+
+	while (status.status == Success and page.isEmpty()) {
+
+		if (!_cursor.pendingPages.isEmpty()) {
+			page = DocumentLayout(QVector<ItemRenderInfos*>{_cursor.pendingPages.takeFirst()});
+			break;
+		}
+
+		ItemRenderInfos* previousPage = nullptr;
+		DocumentItem* item = nullptr;
+
+		if (_cursor.pageHasMore) {
+			previousPage = _cursor.currentPage[0];
+			item = previousPage->item;
+		} else if (_cursor.nextItem < _docTemplate->subitems().size()) {
+			item = _docTemplate->subitems()[_cursor.nextItem];
+			_cursor.nextItem++;
+		} else {
+			break; //the layout is done
+		}
+
+		ItemRenderInfos* itemInfos = allocateNode();
+		itemInfos->item = item;
+		itemInfos->itemValue = (previousPage != nullptr) ? previousPage->itemValue : _cursor.dataInterface->getValue(item->dataKey());
+		itemInfos->currentSize = (previousPage != nullptr) ? previousPage->currentSize : item->initialSize();
+		itemInfos->maxSize = item->maxSize();
+		itemInfos->rendered = false;
+		itemInfos->continuationIndex = QVariant();
+		itemInfos->layoutStatus = Success;
+
+		if (item->getType() != DocumentItem::Page) {
+
+			//other top level items (e.g. loops of pages) are laid out at once, then their pages are given one by one.
+			status = layoutItem(*itemInfos, nullptr);
+			detachLayoutPages(itemInfos, _cursor.pendingPages);
+			discardNode(itemInfos);
+			continue;
+		}
+
+		RenderTracer::Scope traceScope(_tracer, "layout", item, _pagesToWrite+1);
+
+		//same check as layoutItem, the previous page and the pending pages are still alive.
+		if (memoryBudgetExceeded()) {
+			reportDiagnostic(MemoryBudgetExceeded, item, _pagesToWrite, QT_TR_NOOP("Memory budget of %2 bytes exceeded while laying out block: %1"),
+							 QVariantList{_memoryBudget});
+			status = RenderingStatus{MemoryBudgetExceeded};
+			discardNode(itemInfos);
+			break;
+		}
+
+		bool anyItemProgressedRender = false;
+		status = layoutPageInstance(*itemInfos, previousPage, previousPage == nullptr, _cursor.pageHasMore, anyItemProgressedRender);
+
+		if (_cursor.pageHasMore and !anyItemProgressedRender and status.status == Success) {
+			status = layoutError(MissingSpace, item, QT_TR_NOOP("Render loop got stuck without being able to progress on page: %1!"));
+		}
+
+		//the previous page is only needed for its continuation state, the caller might still hold it.
+		_liveNodes -= countLayoutNodes(_cursor.currentPage.items());
+
+		page = DocumentLayout(QVector<ItemRenderInfos*>{itemInfos});
+		_cursor.currentPage = page;
+	}
+
+	layoutTimer.stop();
+
+	_painter = oldPainter;
+	_writer = oldWriter;
+
+	if (status.status != Success) {
+		//no more pages after an error
+		_cursor.nextItem = _docTemplate->subitems().size();
+		_cursor.pageHasMore = false;
+		page = DocumentLayout();
+	}
+
+	updatePeakMemory(_peakLiveNodes);
+	_statistics.pagesProduced = _pagesToWrite;
+
+	_cursor.statistics = _statistics;
+	_cursor.movedDiagnostics = _movedDiagnostics;
+	_cursor.nPages = _pagesToWrite;
+
+	addImageStatistics(ImagePrefetcher::Statistics{0, 0, 0, 0, 0, 0}); //the prefetcher count the images since beginLayout
+	attachResults(status);
+
+	return {page, status, _statistics};
+}
+
+bool DocumentRenderer::hasNextPage() const {
+	return _cursor.dataInterface != nullptr and
+			(_cursor.pageHasMore or
+			 !_cursor.pendingPages.isEmpty() or
+			 _cursor.nextItem < _docTemplate->subitems().size());
+}
+
+void DocumentRenderer::endLayout() {
+
+	for (ItemRenderInfos* page : qAsConst(_cursor.pendingPages)) {
+		delete page;
+	}
+
+	_cursor.pendingPages.clear();
+	_cursor.currentPage = DocumentLayout();
+	_cursor.dataInterface = nullptr;
+	_cursor.pluginManager = nullptr;
+	_cursor.painter = nullptr;
+	_cursor.nextItem = 0;
+	_cursor.pageHasMore = false;
+	_cursor.nPages = 0;
+	_cursor.statistics = RenderStatistics();
+	_cursor.movedDiagnostics.clear();
+}
+
 DocumentRenderer::RenderingStatus DocumentRenderer::render(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, QIODevice* device) {
 
 	_pluginManager = &pluginManager;
@@ -92,11 +1026,66 @@ DocumentRenderer::RenderingStatus DocumentRenderer::render(DocumentDataInterface
 		return RenderingStatus{MissingModel, QObject::tr("Invalid template")};
 	}
 
+	if (_outputCache != nullptr) {
+		return renderWithOutputCache(dataInterface, pluginManager, device);
+	}
+
+	return renderDocument(dataInterface, device, 0, -1);
+}
+
+DocumentRenderer::RenderingStatus DocumentRenderer::renderPages(DocumentDataInterface const* dataInterface,
+																RenderPluginManager const& pluginManager,
+																QIODevice* device,
+																int firstPage,
+																int lastPage) {
+
+	_pluginManager = &pluginManager;
+
+	if (dataInterface == nullptr) {
+		return RenderingStatus{MissingData, QObject::tr("Missing data interface")};
+	}
+
+	if (_docTemplate == nullptr) {
+		return RenderingStatus{MissingModel, QObject::tr("Invalid template")};
+	}
+
+	if (firstPage < 0 or lastPage < firstPage) {
+		return RenderingStatus{OtherError, QObject::tr("Invalid page range: %1-%2").arg(firstPage).arg(lastPage)};
+	}
+
+	return renderDocument(dataInterface, device, firstPage, lastPage);
+}
+
+DocumentRenderer::RenderingStatus DocumentRenderer::renderPages(DocumentDataInterface const* dataInterface,
+																RenderPluginManager const& pluginManager,
+																QString const& filename,
+																int firstPage,
+																int lastPage) {
+
+	QFile out(filename);
+
+	if (!out.open(QFile::WriteOnly)) {
+		return RenderingStatus{MissingModel, QObject::tr("Could not open file")};
+	}
+
+	return renderPages(dataInterface, pluginManager, &out, firstPage, lastPage);
+}
+
+DocumentRenderer::RenderingStatus DocumentRenderer::renderDocument(DocumentDataInterface const* dataInterface,
+																   QIODevice* device,
+																   int firstPage,
+																   int lastPage) {
+
 	if (_writer != nullptr) {
 		delete _writer;
 	}
 
-	_writer = new QPdfWriter(device);
+	_statistics = RenderStatistics();
+	_diagnostics.clear();
+	_movedDiagnostics.clear();
+	CountingDevice countingDevice(device);
+
+	_writer = new QPdfWriter(&countingDevice);
 	_writer->setResolution(72);
 	_writer->setTitle(_docTemplate->objectName());
 	_writer->setPageMargins(QMarginsF(0,0,0,0));
@@ -109,25 +1098,49 @@ DocumentRenderer::RenderingStatus DocumentRenderer::render(DocumentDataInterface
 	_pagesToWrite = 0;
 	_pagesWritten = 0;
 
-	RenderingStatus status{Success, ""};
+	//the pages after the range are not laid out.
+	int maxPages = (lastPage >= 0) ? lastPage+1 : -1;
 
-	QVector<ItemRenderInfos*> layout;
+	QByteArray cacheKey = layoutCacheKey(dataInterface, maxPages);
+	DocumentLayout layout;
 
-	RenderingStatus layoutStatus = layoutDocument(layout, dataInterface);
+	if (!cacheKey.isEmpty() and _layoutCache->load(cacheKey, *_docTemplate, layout)) {
+		_statistics.layoutCacheHits++;
+	} else {
 
-	if (layoutStatus.status != Success) {
-		for (ItemRenderInfos* item : qAsConst(layout)) {
-			if (item != nullptr) {
-				delete item;
-			}
+		QVector<ItemRenderInfos*> layoutItems;
+
+		_maxPages = maxPages;
+		_firstPageToRender = firstPage;
+
+		PhaseTimer layoutTimer(_statistics.layoutWallNs, _statistics.layoutCpuNs);
+		RenderingStatus layoutStatus = layoutDocument(layoutItems, dataInterface);
+		layoutTimer.stop();
+
+		_maxPages = -1;
+		_firstPageToRender = 0;
+
+		addImageStatistics(ImagePrefetcher::Statistics{0, 0, 0, 0, 0, 0}); //the layout reset the prefetcher statistics
+		updatePeakMemory(_peakLiveNodes);
+
+		layout = DocumentLayout(layoutItems);
+
+		if (layoutStatus.status != Success) {
+			delete _painter;
+			delete _writer;
+			_painter = nullptr;
+			_writer = nullptr;
+			attachResults(layoutStatus);
+			return layoutStatus;
+		}
+
+		if (!cacheKey.isEmpty()) {
+			_layoutCache->store(cacheKey, layout);
 		}
-		delete _painter;
-		delete _writer;
-		_painter = nullptr;
-		_writer = nullptr;
-		return layoutStatus;
 	}
 
+	ImagePrefetcher::Statistics layoutImageStatistics = _imagePrefetcher->statistics();
+
 	if (layout.isEmpty()) {
 		delete _painter;
 		delete _writer;
@@ -136,30 +1149,86 @@ DocumentRenderer::RenderingStatus DocumentRenderer::render(DocumentDataInterface
 		return RenderingStatus{MissingModel, QObject::tr("Final layout is empty")};
 	}
 
-	for (ItemRenderInfos* item : layout) {
+	PhaseTimer renderTimer(_statistics.renderWallNs, _statistics.renderCpuNs);
+	RenderingStatus status = renderPageRange(layout.items(), firstPage, lastPage);
 
-		RenderingStatus itemStatus = renderItem(*item);
+	delete _painter;
+	delete _writer;
+	_painter = nullptr;
+	_writer = nullptr;
 
-		if (itemStatus.status != Success) {
-			status.status = itemStatus.status;
-			if (!status.message.isEmpty()) {
-				status.message += "\n";
-			}
-			status.message += itemStatus.message;
-		}
+	renderTimer.stop();
+
+	addImageStatistics(layoutImageStatistics);
+	updatePeakMemory(countLayoutNodes(layout.items()));
+	_statistics.pagesProduced = _pagesWritten;
+	_statistics.bytesWritten = countingDevice.count();
+	attachResults(status);
+
+	return status;
+}
+DocumentRenderer::RenderingStatus DocumentRenderer::renderWithOutputCache(DocumentDataInterface const* dataInterface,
+																		  RenderPluginManager const& pluginManager,
+																		  QIODevice* device) {
+
+	RecordingDataInterface recorder(dataInterface);
+
+	//measure the text on a pdf device, as render does, without writing anything to the output yet.
+	QBuffer scratch;
+	QPdfWriter layoutWriter(&scratch);
+	layoutWriter.setResolution(72);
+	layoutWriter.setPageMargins(QMarginsF(0,0,0,0));
+
+	QPainter layoutPainter(&layoutWriter);
+	LayoutResults layoutResults = layoutHeadless(&recorder, pluginManager, &layoutPainter);
+	layoutPainter.end();
+
+	if (layoutResults.status.status != Success) {
+		return layoutResults.status;
 	}
 
-	for (ItemRenderInfos* item : layout) {
-		delete item;
+	if (layoutResults.layout.isEmpty()) {
+		return RenderingStatus{MissingModel, QObject::tr("Final layout is empty")};
 	}
 
-	delete _painter;
-	delete _writer;
-	_painter = nullptr;
-	_writer = nullptr;
+	QByteArray dataDigest = (layoutResults.statistics.layoutCacheHits > 0) ? dataInterface->contentHash() : recorder.digest();
+
+	QByteArray key;
+
+	if (!dataDigest.isEmpty()) {
+		key = OutputCache::key(*_docTemplate, dataDigest, layoutResults.layout, pluginManager);
+	}
+
+	qint64 cachedSize = 0;
+
+	if (!key.isEmpty() and _outputCache->fetch(key, device, &cachedSize)) {
+		_statistics = layoutResults.statistics;
+		_statistics.outputCacheHits++;
+		_statistics.pagesProduced = getLayoutNPages(layoutResults.layout.items());
+		_statistics.bytesWritten = cachedSize;
+
+		RenderingStatus status{Success};
+		attachResults(status);
+		return status;
+	}
+
+	QBuffer document;
+	RenderingStatus status = render(layoutResults.layout, pluginManager, &document);
+
+	CountingDevice output(device);
+	output.write(document.data());
+
+	if (status.status == Success and !key.isEmpty()) {
+		_outputCache->store(key, document.data());
+	}
+
+	layoutResults.statistics.pagesProduced = 0; //pages laid out, the render count the pages written
+	_statistics += layoutResults.statistics;
+	attachResults(status);
 
 	return status;
 }
+
 DocumentRenderer::RenderingStatus DocumentRenderer::render(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, QString const& filename) {
 
 	QFile out(filename);
@@ -172,7 +1241,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::render(DocumentDataInterface
 }
 
 
-DocumentRenderer::RenderingStatus DocumentRenderer::render(QVector<ItemRenderInfos*> const& layout,
+DocumentRenderer::RenderingStatus DocumentRenderer::render(DocumentLayout const& layout,
                                                            RenderPluginManager const& pluginManager,
                                                            QIODevice* device) {
 
@@ -186,11 +1255,50 @@ DocumentRenderer::RenderingStatus DocumentRenderer::render(QVector<ItemRenderInf
 		return RenderingStatus{MissingModel, QObject::tr("Invalid template")};
 	}
 
+	return renderLayout(layout, device, 0, -1);
+}
+
+DocumentRenderer::RenderingStatus DocumentRenderer::renderPages(DocumentLayout const& layout,
+																RenderPluginManager const& pluginManager,
+																QIODevice* device,
+																int firstPage,
+																int lastPage) {
+
+	_pluginManager = &pluginManager;
+
+	if (layout.isEmpty()) {
+		return RenderingStatus{MissingData, QObject::tr("Missing layout")};
+	}
+
+	if (_docTemplate == nullptr) {
+		return RenderingStatus{MissingModel, QObject::tr("Invalid template")};
+	}
+
+	if (firstPage < 0 or lastPage < firstPage) {
+		return RenderingStatus{OtherError, QObject::tr("Invalid page range: %1-%2").arg(firstPage).arg(lastPage)};
+	}
+
+	return renderLayout(layout, device, firstPage, lastPage);
+}
+
+DocumentRenderer::RenderingStatus DocumentRenderer::renderLayout(DocumentLayout const& layout,
+																 QIODevice* device,
+																 int firstPage,
+																 int lastPage) {
+
 	if (_writer != nullptr) {
 		delete _writer;
 	}
 
-	_writer = new QPdfWriter(device);
+	_statistics = RenderStatistics();
+	_diagnostics.clear();
+	_movedDiagnostics.clear();
+	ImagePrefetcher::Statistics imageStatistics = _imagePrefetcher->statistics();
+	CountingDevice countingDevice(device);
+
+	PhaseTimer renderTimer(_statistics.renderWallNs, _statistics.renderCpuNs);
+
+	_writer = new QPdfWriter(&countingDevice);
 	_writer->setResolution(72);
 	_writer->setTitle(_docTemplate->objectName());
 	_writer->setPageMargins(QMarginsF(0,0,0,0));
@@ -203,35 +1311,25 @@ DocumentRenderer::RenderingStatus DocumentRenderer::render(QVector<ItemRenderInf
 	_pagesToWrite = 0;
 	_pagesWritten = 0;
 
-	RenderingStatus status{Success, ""};
-
-	for (ItemRenderInfos* item : layout) {
-
-		RenderingStatus itemStatus = renderItem(*item);
-
-		if (itemStatus.status != Success) {
-			status.status = itemStatus.status;
-			if (!status.message.isEmpty()) {
-				status.message += "\n";
-			}
-			status.message += itemStatus.message;
-		}
-	}
-
-    for (ItemRenderInfos* item : layout) {
-        delete item;
-    }
-
+	RenderingStatus status = renderPageRange(layout.items(), firstPage, lastPage);
 
 	delete _painter;
 	delete _writer;
 	_painter = nullptr;
 	_writer = nullptr;
 
+	renderTimer.stop();
+
+	addImageStatistics(imageStatistics);
+	updatePeakMemory(countLayoutNodes(layout.items()));
+	_statistics.pagesProduced = _pagesWritten;
+	_statistics.bytesWritten = countingDevice.count();
+	attachResults(status);
+
 	return status;
 }
 
-DocumentRenderer::RenderingStatus DocumentRenderer::render(QVector<ItemRenderInfos*> const& layout,
+DocumentRenderer::RenderingStatus DocumentRenderer::render(DocumentLayout const& layout,
                                                            RenderPluginManager const& pluginManager,
                                                            QString const& filename) {
 
@@ -245,25 +1343,351 @@ DocumentRenderer::RenderingStatus DocumentRenderer::render(QVector<ItemRenderInf
 
 }
 
-DocumentRenderer::RenderingStatus DocumentRenderer::renderItemToExternalPainter(ItemRenderInfos& itemInfos, QPainter* painterOverride) {
+DocumentRenderer::RenderingStatus DocumentRenderer::renderItemToExternalPainter(ItemRenderInfos& itemInfos, QPainter* painterOverride, QPointF const& parentsOffset) {
     if (painterOverride == nullptr) {
         return RenderingStatus{Status::OtherError, "Cannot render on null painter override"};
     }
 
     QPainter* oldPainter = _painter;
     QPdfWriter* oldWriter = _writer;
+    QPointF oldOffset = _renderOffset;
 
     _painter = painterOverride;
     _writer = nullptr; //no writer means pageless mode
+    _renderOffset = parentsOffset;
 
     RenderingStatus status = renderItem(itemInfos);
 
     _painter = oldPainter;
     _writer = oldWriter;
+    _renderOffset = oldOffset;
 
     return status;
 }
 
+DocumentRenderer::RenderingStatus DocumentRenderer::renderToImages(DocumentLayout const& layout,
+																   RenderPluginManager const& pluginManager,
+																   QString const& filePattern,
+																   qreal dpi,
+																   QByteArray const& format) {
+
+	_pluginManager = &pluginManager;
+
+	if (layout.isEmpty()) {
+		return RenderingStatus{MissingData, QObject::tr("Missing layout")};
+	}
+
+	if (_docTemplate == nullptr) {
+		return RenderingStatus{MissingModel, QObject::tr("Invalid template")};
+	}
+
+	if (dpi <= 0) {
+		return RenderingStatus{OtherError, QObject::tr("Invalid resolution: %1").arg(dpi)};
+	}
+
+	QVector<ItemRenderInfos*> pages;
+	QVector<QPointF> offsets;
+	collectLayoutPages(layout.items(), pages, &offsets);
+
+	if (pages.isEmpty()) {
+		return RenderingStatus{MissingModel, QObject::tr("Final layout is empty")};
+	}
+
+	_statistics = RenderStatistics();
+	_diagnostics.clear();
+	_movedDiagnostics.clear();
+	ImagePrefetcher::Statistics imageStatistics = _imagePrefetcher->statistics();
+	PhaseTimer renderTimer(_statistics.renderWallNs, _statistics.renderCpuNs);
+
+	QVector<RenderingStatus> pagesStatus(pages.size(), RenderingStatus{Success});
+	QVector<RenderStatistics> pagesStatistics(pages.size());
+
+	//use a dedicated pool, as the workers wait for their plugin jobs.
+	QThreadPool pool;
+	pluginPool(); //created before the workers, which all share it
+
+	qint64 largestPageBytes = 0;
+
+	for (ItemRenderInfos* page : qAsConst(pages)) {
+		qint64 pageBytes = 4*static_cast<qint64>(std::ceil(page->currentSize.width()*dpi/72.))*
+				static_cast<qint64>(std::ceil(page->currentSize.height()*dpi/72.));
+		largestPageBytes = std::max(largestPageBytes, pageBytes);
+	}
+
+	for (int i = 0; i < pages.size(); i++) {
+		pool.start(new PageRasterJob(this, pages[i], offsets[i], i, filePattern.arg(i+1), dpi, format, &pagesStatus[i], &pagesStatistics[i]));
+	}
+
+	pool.waitForDone();
+
+	renderTimer.stop();
+
+	for (RenderStatistics const& pageStatistics : qAsConst(pagesStatistics)) {
+		_statistics += pageStatistics;
+	}
+
+	addImageStatistics(imageStatistics);
+	updatePeakMemory(countLayoutNodes(layout.items()));
+	//each worker hold the image of its page
+	_statistics.peakMemoryBytes += std::min(pool.maxThreadCount(), pages.size())*largestPageBytes;
+
+	RenderingStatus status{Success};
+
+	for (int i = 0; i < pagesStatus.size(); i++) {
+
+		RenderingStatus const& pageStatus = pagesStatus[i];
+
+		if (!pageStatus.diagnostics.isNull()) {
+			_diagnostics += *pageStatus.diagnostics;
+		} else if (pageStatus.status != Success) {
+			reportDiagnostic(pageStatus.status, pages[i]->item, i, nullptr, pageStatus.message);
+		}
+
+		if (pageStatus.status != Success) {
+			status.status = pageStatus.status;
+		}
+	}
+
+	attachResults(status);
+
+	return status;
+}
+
+ImagePrefetcher::Statistics DocumentRenderer::imagePrefetchStatistics() const {
+	return _imagePrefetcher->statistics();
+}
+
+void DocumentRenderer::setImageCacheLimit(qint64 bytes) {
+	_imagePrefetcher->setMemoryLimit(bytes);
+}
+
+void DocumentRenderer::setTracer(RenderTracer* tracer) {
+	_tracer = tracer;
+}
+
+void DocumentRenderer::setLayoutCache(LayoutCache* cache) {
+	_layoutCache = cache;
+}
+
+QByteArray DocumentRenderer::layoutCacheKey(DocumentDataInterface const* dataInterface, int maxPages) const {
+
+	if (_layoutCache == nullptr or dataInterface == nullptr or _docTemplate == nullptr) {
+		return QByteArray();
+	}
+
+	if (maxPages > 0) { //partial layouts are not cached
+		return QByteArray();
+	}
+
+	//the text is measured on the painter device, so the layout depends on its resolution.
+	QByteArray context;
+
+	if (_painter != nullptr and _painter->device() != nullptr) {
+		context = QByteArray::number(_painter->device()->logicalDpiX()) + "x" + QByteArray::number(_painter->device()->logicalDpiY());
+	}
+
+	return LayoutCache::key(*_docTemplate, *dataInterface, context, _pluginManager);
+}
+
+void DocumentRenderer::setOutputCache(OutputCache* cache) {
+	_outputCache = cache;
+}
+
+void DocumentRenderer::setMemoryBudget(qint64 bytes) {
+	_memoryBudget = bytes;
+}
+
+ItemRenderInfos* DocumentRenderer::allocateNode() {
+
+	_statistics.nodesAllocated++;
+	_liveNodes++;
+	_peakLiveNodes = std::max(_peakLiveNodes, _liveNodes);
+
+	return new ItemRenderInfos();
+}
+
+void DocumentRenderer::discardNode(ItemRenderInfos* node) {
+
+	if (node == nullptr) {
+		return;
+	}
+
+	_liveNodes -= 1 + countLayoutNodes(node->subitemsRenderInfos);
+	delete node;
+}
+
+qint64 DocumentRenderer::estimatedMemoryUsage(qint64 nNodes) const {
+	return nNodes*layoutNodeBytes +
+			_rowTextMeasurements.capacity()*qint64(sizeof(TextMeasurement)) +
+			_imagePrefetcher->memoryUsage();
+}
+
+bool DocumentRenderer::memoryBudgetExceeded() const {
+
+	if (_memoryBudget <= 0) {
+		return false;
+	}
+
+	return estimatedMemoryUsage(_liveNodes) > _memoryBudget;
+}
+
+void DocumentRenderer::updatePeakMemory(qint64 nNodes) {
+	_statistics.peakMemoryBytes = std::max(_statistics.peakMemoryBytes, estimatedMemoryUsage(nNodes));
+}
+
+void DocumentRenderer::addImageStatistics(ImagePrefetcher::Statistics const& since) {
+	ImagePrefetcher::Statistics current = _imagePrefetcher->statistics();
+	_statistics.imagesDecoded += current.decoded - since.decoded;
+	_statistics.imageBytesRead += current.bytesRead - since.bytesRead;
+}
+
+void DocumentRenderer::attachResults(RenderingStatus & status) const {
+
+	status.statistics = QSharedPointer<const RenderStatistics>(new RenderStatistics(_statistics));
+
+	if (!_diagnostics.isEmpty()) {
+		status.diagnostics = QSharedPointer<const QVector<Diagnostic>>(new QVector<Diagnostic>(_diagnostics));
+	}
+
+	//the text is only built for failures, warnings of successful runs can be formatted with diagnosticsText.
+	if (status.status != Success and status.message.isEmpty()) {
+		status.message = diagnosticsText(_diagnostics);
+	}
+}
+
+void DocumentRenderer::reportDiagnostic(Status code, DocumentItem const* item, int page, char const* text, QString const& detail) {
+	recordDiagnostic(Diagnostic{code, item, page, text, detail, QVariantList()});
+}
+
+void DocumentRenderer::reportDiagnostic(Status code, DocumentItem const* item, int page, char const* text, QVariantList const& arguments) {
+	recordDiagnostic(Diagnostic{code, item, page, text, QString(), arguments});
+}
+
+void DocumentRenderer::recordDiagnostic(Diagnostic const& diagnostic) {
+
+	//a warning already reported by an item moved to the next page
+	for (int i = 0; i < _movedDiagnostics.size(); i++) {
+		Diagnostic const& moved = _movedDiagnostics[i];
+
+		if (moved.code == diagnostic.code and
+				moved.item == diagnostic.item and
+				moved.text == diagnostic.text and
+				moved.detail == diagnostic.detail and
+				moved.arguments == diagnostic.arguments) {
+			_movedDiagnostics.remove(i);
+			return;
+		}
+	}
+
+	_diagnostics.push_back(diagnostic);
+}
+
+void DocumentRenderer::dropMovedItemDiagnostics(int mark) {
+
+	int nKept = mark;
+
+	for (int i = mark; i < _diagnostics.size(); i++) {
+		if (_diagnostics[i].code != Success) {
+			continue;
+		}
+
+		_movedDiagnostics.push_back(_diagnostics[i]);
+		_diagnostics[nKept] = _diagnostics[i];
+		nKept++;
+	}
+
+	_diagnostics.resize(nKept);
+}
+
+DocumentRenderer::RenderingStatus DocumentRenderer::layoutError(Status code, DocumentItem const* item, char const* text) {
+	reportDiagnostic(code, item, _pagesToWrite, text);
+	return RenderingStatus{code};
+}
+
+DocumentRenderer::RenderingStatus DocumentRenderer::renderError(Status code, DocumentItem const* item, char const* text) {
+	reportDiagnostic(code, item, _pagesWritten, text);
+	return RenderingStatus{code};
+}
+
+DocumentRenderer::RenderingStatus DocumentRenderer::pluginStatus(RenderingStatus const& status, DocumentItem const* item) {
+
+	if (status.status == Success) {
+		return status;
+	}
+
+	//the message of the plugin is only inserted in the text if the diagnostics are formatted
+	reportDiagnostic(status.status, item, _pagesWritten, QT_TR_NOOP("Plugin: %1 failed: %2"), QVariantList{status.message});
+	return RenderingStatus{status.status, QString(), status.renderSize, status.anyItemProgressedRender};
+}
+
+QString DocumentRenderer::Diagnostic::toString() const {
+
+	QString message = (text != nullptr) ? QObject::tr(text) : detail;
+
+	if (text != nullptr) {
+		QString name = (item != nullptr) ? item->objectName() : QString();
+
+		//all the markers are replaced at once, so the values cannot introduce new markers
+		switch (arguments.size()) {
+		case 0:
+			if (message.contains("%1")) {
+				message = message.arg(name);
+			}
+			break;
+		case 1:
+			message = message.arg(name, arguments[0].toString());
+			break;
+		default:
+			message = message.arg(name, arguments[0].toString(), arguments[1].toString());
+			break;
+		}
+	}
+
+	if (page >= 0) {
+		message = QObject::tr("Page %1: %2").arg(page+1).arg(message);
+	}
+
+	return message;
+}
+
+QString DocumentRenderer::diagnosticsText(QVector<Diagnostic> const& diagnostics) {
+
+	QStringList lines;
+	lines.reserve(diagnostics.size());
+
+	for (Diagnostic const& diagnostic : diagnostics) {
+		lines << diagnostic.toString();
+	}
+
+	return lines.join("\n");
+}
+
+void DocumentRenderer::collectLayoutPages(QVector<ItemRenderInfos*> const& layout, QVector<ItemRenderInfos*> & pages, QVector<QPointF>* offsets) {
+	collectLayoutPages(layout, pages, offsets, QPointF(0,0));
+}
+
+void DocumentRenderer::collectLayoutPages(QVector<ItemRenderInfos*> const& layout,
+										  QVector<ItemRenderInfos*> & pages,
+										  QVector<QPointF>* offsets,
+										  QPointF const& parentsOffset) {
+
+	for (ItemRenderInfos* itemInfos : layout) {
+		if (itemInfos == nullptr or itemInfos->item == nullptr or !itemInfos->toRender) {
+			continue;
+		}
+
+		if (itemInfos->item->getType() == DocumentItem::Page) {
+			pages.push_back(itemInfos);
+
+			if (offsets != nullptr) {
+				offsets->push_back(parentsOffset);
+			}
+		} else {
+			collectLayoutPages(itemInfos->subitemsRenderInfos, pages, offsets, parentsOffset + itemInfos->subitemsOffset);
+		}
+	}
+}
+
 int DocumentRenderer::getLayoutNPages(QVector<ItemRenderInfos*> const& layout) {
     int n = 0;
 
@@ -305,27 +1729,37 @@ ItemRenderInfos* DocumentRenderer::getLayoutNthPage(QVector<ItemRenderInfos*> co
 
 void ItemRenderInfos::translate(QPointF const& delta) {
 	currentOrigin += delta;
-
-	for (ItemRenderInfos* subItemInfos : subitemsRenderInfos) {
-		if (subItemInfos != nullptr) {
-			subItemInfos->translate(delta);
-		}
-	}
+	subitemsOffset += delta;
 }
 
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutDocument(QVector<ItemRenderInfos*> & topLevel, DocumentDataInterface const* dataInterface) {
 
 	if (_docTemplate == nullptr) {
-		return RenderingStatus{OtherError, QObject::tr("Invalid template")};
+		return layoutError(OtherError, nullptr, QT_TR_NOOP("Invalid template"));
 	}
 
-	RenderingStatus status{Success, ""};
+	//images and measurements from a previous layout are not needed anymore
+	_imagePrefetcher->clear();
+	_imagePrefetcher->resetStatistics();
+	_rowTextMeasurements.clear();
+	_movedRowMeasurements = nullptr;
+	_loopDepth = 0;
+
+	_pagesToWrite = 0;
+	_liveNodes = 0;
+	_peakLiveNodes = 0;
+
+	RenderingStatus status{Success};
 
 	for (DocumentItem* item : _docTemplate->subitems()) {
 
+		if (pageLimitReached()) {
+			break;
+		}
+
 		DocumentValue val = dataInterface->getValue(item->dataKey());
 
-		ItemRenderInfos* itemInfos = new ItemRenderInfos();
+		ItemRenderInfos* itemInfos = allocateNode();
 		itemInfos->item = item;
 		itemInfos->itemValue = val;
 		itemInfos->currentSize = item->initialSize();
@@ -339,10 +1773,6 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutDocument(QVector<ItemR
 
 		if (itemStatus.status != Success) {
 			status.status = itemStatus.status;
-			if (!status.message.isEmpty()) {
-				status.message += "\n";
-			}
-			status.message += itemStatus.message;
 		}
 	}
 
@@ -351,6 +1781,14 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutDocument(QVector<ItemR
 }
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutItem(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender, QVector<ItemRenderInfos*>* targetItemPool) {
 
+	RenderTracer::Scope traceScope(_tracer, "layout", itemInfos.item, _pagesToWrite+1);
+
+	if (memoryBudgetExceeded()) {
+		reportDiagnostic(MemoryBudgetExceeded, itemInfos.item, _pagesToWrite, QT_TR_NOOP("Memory budget of %2 bytes exceeded while laying out block: %1"),
+						 QVariantList{_memoryBudget});
+		return RenderingStatus{MemoryBudgetExceeded};
+	}
+
 	if (previousRender != nullptr) {
 		if (previousRender->layoutStatus == Success) {
 
@@ -382,32 +1820,29 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutItem(ItemRenderInfos&
 	case DocumentItem::Type::Plugin:
 		return layoutPlugin(itemInfos, previousRender);
 	case DocumentItem::Type::Invalid:
-		return RenderingStatus{OtherError, QObject::tr("Invalid block : %1").arg(itemInfos.item->objectName())};
+		return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("Invalid block : %1"));
 	}
 
-	return RenderingStatus{OtherError, QObject::tr("Unknown error for block : %1").arg(itemInfos.item->objectName())};
+	return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("Unknown error for block : %1"));
 
 	rerender_error:
-	return RenderingStatus{OtherError, QObject::tr("Requested to rerender an already rendered item!").arg(itemInfos.item->objectName())};
+	return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("Requested to rerender an already rendered item!"));
 
 }
 
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutCondition(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender) {
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel,
-					QObject::tr("Invalid item requested!")};
+		return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
     }
 
     if (itemInfos.item->subitems().size() != 1 and itemInfos.item->subitems().size() != 2) {
-		return RenderingStatus{MissingModel,
-                    QObject::tr("Condition : %1, does not have one or two subitems, conditions should have exactly one or two subitems").arg(itemInfos.item->objectName())};
+		return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Condition : %1, does not have one or two subitems, conditions should have exactly one or two subitems"));
 	}
 
     if (!itemInfos.itemValue.hasMap()) { //no data
         if (itemInfos.item->subitems().size() == 2) { //in the case an alternative item is provided, one need some data for the subitem
-            return RenderingStatus{MissingData,
-                                   QObject::tr("Cannot read context map for condition : %1").arg(itemInfos.item->objectName())};
+            return layoutError(MissingData, itemInfos.item, QT_TR_NOOP("Cannot read context map for condition : %1"));
         } else { //in the case of a single item, no data just mean the condition should be evaluated to false
             RenderingStatus ret{Success};
             ret.renderSize = QSizeF(0,0); // if no target item and no error up to that point layout nothing!
@@ -446,7 +1881,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutCondition(ItemRenderIn
 
 	DocumentValue target_val = itemInfos.itemValue.getValue(target_item->dataKey());
 
-	ItemRenderInfos* subItemInfos = new ItemRenderInfos();
+	ItemRenderInfos* subItemInfos = allocateNode();
 	subItemInfos->item = target_item;
 	subItemInfos->itemValue = target_val;
 	subItemInfos->currentSize = target_item->initialSize();
@@ -481,7 +1916,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutCondition(ItemRenderIn
     }
 
 	if (no_render_needed) {
-		delete subItemInfos;
+		discardNode(subItemInfos);
 		return RenderingStatus{Success};
 	}
 
@@ -492,17 +1927,15 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutCondition(ItemRenderIn
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender) {
 
     if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
 	if (!itemInfos.itemValue.hasArray()) {
-		return RenderingStatus{MissingData,
-					QObject::tr("Cannot read context array for loop : %1").arg(itemInfos.item->objectName())};
+		return layoutError(MissingData, itemInfos.item, QT_TR_NOOP("Cannot read context array for loop : %1"));
 	}
 
 	if (itemInfos.item->subitems().size() != 1) {
-		return RenderingStatus{MissingModel,
-					QObject::tr("Loop : %1, does not have one subitem, loops should have exactly one subitem (the delegate)").arg(itemInfos.item->objectName())};
+		return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Loop : %1, does not have one subitem, loops should have exactly one subitem (the delegate)"));
 	}
 
 	int nCopies = itemInfos.itemValue.arraySize();
@@ -527,8 +1960,6 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
         renderSize.setHeight(_renderContext.region.height());
     }
 
-	QString message = "";
-
 	int startsId = 0;
 	itemInfos.layoutStatus = Success;
 
@@ -537,8 +1968,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 			startsId = previousRender->continuationIndex.toInt();
 
 			if (previousRender->subitemsRenderInfos.isEmpty()) {
-				return RenderingStatus{OtherError,
-							QObject::tr("Loop with empty non null previous render should not occur").arg(itemInfos.item->objectName())};
+				return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("Loop with empty non null previous render should not occur"));
 			}
 
 			if (previousRender->subitemsRenderInfos.last()->layoutStatus != NotAllItemsRendered) {
@@ -559,14 +1989,16 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 
 	if (startsId >= nCopies) {
 		itemInfos.layoutStatus = Success;
-        return RenderingStatus{Success, "", renderSize, true};
+        return RenderingStatus{Success, QString(), renderSize, true};
 	}
 
     bool madeProgress = false;
 
+	_loopDepth++;
+
 	for (int i = startsId; i < nCopies; i++) {
 
-		ItemRenderInfos* subItemInfos = new ItemRenderInfos();
+		ItemRenderInfos* subItemInfos = allocateNode();
 		subItemInfos->item = itemInfos.item->subitems()[0];
 		subItemInfos->itemValue = itemInfos.itemValue.getValue(i);
 		subItemInfos->currentSize = subItemInfos->item->initialSize();
@@ -587,8 +2019,23 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 			}
         }
 
+		if (_loopDepth == 1) {
+			_rowTextMeasurements.clear(); //only the current row of the outermost loop can be moved
+		}
+
+		//a row moved from the previous page reuses the measurements of its texts
+		QVector<TextMeasurement> const* parentMovedRowMeasurements = _movedRowMeasurements;
+
+		if (previousRender != nullptr and i == startsId and !previousRender->movedRowMeasurements.isEmpty()) {
+			_movedRowMeasurements = &previousRender->movedRowMeasurements;
+		}
+
+		int diagnosticsMark = _diagnostics.size();
+		int measurementsMark = _rowTextMeasurements.size();
 		RenderingStatus layoutStatus = layoutItem(*subItemInfos, previousInfos, &itemInfos.subitemsRenderInfos);
 
+		_movedRowMeasurements = parentMovedRowMeasurements;
+
 		itemInfos.continuationIndex = i;
 
         if (i != startsId) {
@@ -602,13 +2049,14 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 		if (layoutStatus.status == MissingSpace) {
 			if (i == startsId) {
 				itemInfos.layoutStatus = MissingSpace;
-				message = layoutStatus.message +
-						QString("\n Table: %1 missing space to render at least one item").arg(itemInfos.item->objectName());
+				reportDiagnostic(MissingSpace, itemInfos.item, _pagesToWrite, QT_TR_NOOP("Table: %1 missing space to render at least one item"));
 			} else {
+				dropMovedItemDiagnostics(diagnosticsMark); //not an error, the item is moved to the next page
+				itemInfos.movedRowMeasurements = _rowTextMeasurements.mid(measurementsMark);
 				subItemInfos->toRender = false;
 				itemInfos.layoutStatus = NotAllItemsRendered;
 				itemInfos.subitemsRenderInfos.removeLast();
-				delete subItemInfos;
+				discardNode(subItemInfos);
                 itemInfos.continuationIndex = i-1; //if the previous item still has elements to render
 			}
 			break;
@@ -630,8 +2078,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 			break;
         } else if (layoutStatus.status != Success) {
             itemInfos.layoutStatus = layoutStatus.status;
-            message = layoutStatus.message +
-                      QString("\n Table: %1 other error while rendering the object!").arg(itemInfos.item->objectName());
+            reportDiagnostic(layoutStatus.status, itemInfos.item, _pagesToWrite, QT_TR_NOOP("Table: %1 other error while rendering the object!"));
 			break;
 		}
 
@@ -664,6 +2111,12 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 		}
 	}
 
+	_loopDepth--;
+
+	if (_loopDepth == 0) {
+		_rowTextMeasurements.clear();
+	}
+
 	//deal with remaining empty space.
 
 	qreal remaining_space = 0;
@@ -709,18 +2162,18 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 
 		if (itemInfos.item->direction() == DocumentItem::Top2Bottom) {
 
-			itemInfos.subitemsRenderInfos[i]->currentOrigin.ry() += pos_delta;
+			itemInfos.subitemsRenderInfos[i]->translate(QPointF(0,pos_delta));
 
 		} else if (itemInfos.item->direction() == DocumentItem::Bottom2Top) {
 
-			itemInfos.subitemsRenderInfos[i]->currentOrigin.ry() -= pos_delta;
+			itemInfos.subitemsRenderInfos[i]->translate(QPointF(0,-pos_delta));
 
 		} else if (itemInfos.item->direction() == DocumentItem::Left2Right) {
 
-			itemInfos.subitemsRenderInfos[i]->currentOrigin.rx() += pos_delta;
+			itemInfos.subitemsRenderInfos[i]->translate(QPointF(pos_delta,0));
 
 		} else {
-			itemInfos.subitemsRenderInfos[i]->currentOrigin.rx() -= pos_delta;
+			itemInfos.subitemsRenderInfos[i]->translate(QPointF(-pos_delta,0));
 		}
 
 		if (itemInfos.subitemsRenderInfos[i]->item->layoutExpandBehavior() != DocumentItem::LayoutExpandBehavior::NotExpand) {
@@ -732,7 +2185,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 					itemInfos.subitemsRenderInfos[i]->currentSize.rheight() += expand_amount;
 
 					if (itemInfos.item->direction() == DocumentItem::Bottom2Top ) {
-						itemInfos.subitemsRenderInfos[i]->currentOrigin.ry() -= expand_amount;
+						itemInfos.subitemsRenderInfos[i]->translate(QPointF(0,-expand_amount));
 					}
 
 				} else if (itemInfos.subitemsRenderInfos[i]->item->layoutExpandBehavior() == DocumentItem::LayoutExpandBehavior:: ExpandMargins) {
@@ -740,9 +2193,11 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 					qreal scale = (itemInfos.item->direction() == DocumentItem::Bottom2Top ) ? -1 : 1;
 
 					auto marginExpandBehavior = itemInfos.subitemsRenderInfos[i]->item->marginsExpandBehavior();
-					itemInfos.subitemsRenderInfos[i]->currentOrigin.ry() +=
+					qreal dy =
 							scale * ((marginExpandBehavior == DocumentItem::ExpandBefore) ? expand_amount :
 																				   ((marginExpandBehavior == DocumentItem::ExpandBoth) ? expand_amount/2 : 0));
+
+					itemInfos.subitemsRenderInfos[i]->translate(QPointF(0,dy));
 				}
 
 			} else {
@@ -751,7 +2206,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 					itemInfos.subitemsRenderInfos[i]->currentSize.rwidth() += expand_amount;
 
 					if (itemInfos.item->direction() == DocumentItem::Right2Left ) {
-						itemInfos.subitemsRenderInfos[i]->currentOrigin.rx() -= expand_amount;
+						itemInfos.subitemsRenderInfos[i]->translate(QPointF(-expand_amount,0));
 					}
 
 				} else if (itemInfos.subitemsRenderInfos[i]->item->layoutExpandBehavior() == DocumentItem::LayoutExpandBehavior:: ExpandMargins) {
@@ -759,9 +2214,11 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 					qreal scale = (itemInfos.item->direction() == DocumentItem::Right2Left ) ? -1 : 1;
 
 					auto marginExpandBehavior = itemInfos.subitemsRenderInfos[i]->item->marginsExpandBehavior();
-					itemInfos.subitemsRenderInfos[i]->currentOrigin.rx() +=
+					qreal dx =
 							scale * ((marginExpandBehavior == DocumentItem::ExpandBefore) ? expand_amount :
 																				   ((marginExpandBehavior == DocumentItem::ExpandBoth) ? expand_amount/2 : 0));
+
+					itemInfos.subitemsRenderInfos[i]->translate(QPointF(dx,0));
 				}
 			}
 
@@ -776,21 +2233,23 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutLoop(ItemRenderInfos&
 
     renderSize.rwidth() += itemInfos.item->origin().x();
     renderSize.rheight() += itemInfos.item->origin().y();
-    return RenderingStatus{itemInfos.layoutStatus, message, renderSize, madeProgress};
+    return RenderingStatus{itemInfos.layoutStatus, QString(), renderSize, madeProgress};
 
 }
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutPage(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender, QVector<ItemRenderInfos*>* targetItemPool) {
 
 	if (itemInfos.item == nullptr) {
-        return RenderingStatus(MissingModel, QObject::tr("Invalid item requested!"), false);
+        return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
-    _renderContext = RenderContext{itemInfos.item->direction(), QPointF(0,0), itemInfos.item->initialSize(), itemInfos.item->initialSize()}; //init the context to the page size
-    itemInfos.currentSize = itemInfos.item->initialSize();
+	if (pageLimitReached()) { //e.g. pages in a loop, after the requested number of pages.
+		itemInfos.toRender = false;
+		return RenderingStatus{Success};
+	}
 
-	RenderingStatus status{Success, ""};
+    itemInfos.currentSize = itemInfos.item->initialSize();
 
-	int nItems = itemInfos.item->subitems().size();
+	RenderingStatus status{Success};
 
 	bool hasMoreToRender = false;
     bool anyItemProgressedRender = false;
@@ -801,95 +2260,32 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutPage(ItemRenderInfos&
 
 	do {
 
-		hasMoreToRender = false;
-        anyItemProgressedRender = false;
-
-		for (int i = 0; i < nItems; i++) {
-
-			if (!isFirst and itemInfos.item->subitems()[i]->overflowBehavior() == DocumentItem::DrawFirstInstanceOnly) {
-
-				currentPageInfos->subitemsRenderInfos.push_back(nullptr);
-				continue; //skip items configured to draw first instance only.
-			}
-
-			ItemRenderInfos* subItemInfos = new ItemRenderInfos();
-			subItemInfos->item = itemInfos.item->subitems()[i];
-			subItemInfos->itemValue = itemInfos.itemValue.getValue(subItemInfos->item->dataKey());
-			subItemInfos->currentSize = subItemInfos->item->initialSize();
-			subItemInfos->maxSize = subItemInfos->item->maxSize();
-			subItemInfos->rendered = false;
-			subItemInfos->continuationIndex = QVariant();
-			subItemInfos->layoutStatus = Success;
-
-			ItemRenderInfos* previousItemRenderInfos = nullptr;
-
-			if (previousPageInfos != nullptr) {
-				if (previousPageInfos->subitemsRenderInfos.size() > i) {
-					previousItemRenderInfos = previousPageInfos->subitemsRenderInfos[i];
-				}
-			}
-
-			if (previousItemRenderInfos != nullptr) {
-				if (previousItemRenderInfos->layoutStatus == Success) {
-
-					if (previousItemRenderInfos->item != nullptr) {
-						if (previousItemRenderInfos->item->overflowBehavior() != DocumentItem::OverflowBehavior::CopyOnNewPages) {
-							delete subItemInfos;
-							currentPageInfos->subitemsRenderInfos.push_back(nullptr);
-							continue;
-						}
-					} else {
-						delete subItemInfos;
-						currentPageInfos->subitemsRenderInfos.push_back(nullptr);
-						continue;
-					}
-				}
-			}
+		RenderingStatus pageStatus = layoutPageInstance(*currentPageInfos, previousPageInfos, isFirst, hasMoreToRender, anyItemProgressedRender);
 
-			currentPageInfos->subitemsRenderInfos.push_back(subItemInfos);
-
-			RenderingStatus itemStatus = layoutItem(*subItemInfos, previousItemRenderInfos);
-
-            if (itemStatus.status == NotAllItemsRendered) {
-                if (subItemInfos->item->overflowBehavior() == DocumentItem::OverflowOnNewPage) {
-                    anyItemProgressedRender |= itemStatus.anyItemProgressedRender;
-                    hasMoreToRender = true;
-                } else if (subItemInfos->item->overflowBehavior() == DocumentItem::CopyOnNewPages) {
-                    anyItemProgressedRender |= itemStatus.anyItemProgressedRender;
-                    hasMoreToRender = true;
-                } else {
-					status.status = MissingSpace;
-					if (!status.message.isEmpty()) {
-						status.message += "\n";
-					}
-					status.message += "Missing space for non-overflowing item";
-				}
-			} else if (itemStatus.status != Success) {
-				status.status = itemStatus.status;
-				if (!status.message.isEmpty()) {
-					status.message += "\n";
-				}
-				status.message += itemStatus.message;
-            } else {
-                anyItemProgressedRender = true; //an item sucessfully rendered
-            }
+		if (pageStatus.status != Success) {
+			status.status = pageStatus.status;
 		}
 
-		_pagesToWrite++;
 		isFirst = false;
 
 		if (targetItemPool == nullptr) {
 			break; //impossible to add more pages if no targetItemPool provided
 		}
 
+		if (pageLimitReached()) {
+			break; //the remaining content is not needed
+		}
+
+		if (status.status == MemoryBudgetExceeded) {
+			break; //fail fast, instead of adding pages which will fail too
+		}
+
 		if (hasMoreToRender) {
             if (!anyItemProgressedRender) {
-                return RenderingStatus(MissingSpace,
-                                       QObject::tr("Render loop got stuck without being able to progress on page: %1!").arg(currentPageInfos->item->objectName()),
-                                       false);
+                return layoutError(MissingSpace, currentPageInfos->item, QT_TR_NOOP("Render loop got stuck without being able to progress on page: %1!"));
             }
 			previousPageInfos = currentPageInfos;
-			currentPageInfos = new ItemRenderInfos();
+			currentPageInfos = allocateNode();
 			currentPageInfos->item = itemInfos.item;
 			currentPageInfos->itemValue = itemInfos.itemValue;
 			currentPageInfos->currentSize = itemInfos.currentSize;
@@ -905,10 +2301,93 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutPage(ItemRenderInfos&
 
 	return status;
 }
+DocumentRenderer::RenderingStatus DocumentRenderer::layoutPageInstance(ItemRenderInfos& pageInfos,
+																	   ItemRenderInfos* previousPageInfos,
+																	   bool isFirst,
+																	   bool & hasMoreToRender,
+																	   bool & anyItemProgressedRender) {
+
+	_renderContext = RenderContext{pageInfos.item->direction(), QPointF(0,0), pageInfos.item->initialSize(), pageInfos.item->initialSize()}; //init the context to the page size
+
+	RenderingStatus status{Success};
+
+	int nItems = pageInfos.item->subitems().size();
+
+	hasMoreToRender = false;
+	anyItemProgressedRender = false;
+
+	for (int i = 0; i < nItems; i++) {
+
+		if (!isFirst and pageInfos.item->subitems()[i]->overflowBehavior() == DocumentItem::DrawFirstInstanceOnly) {
+
+			pageInfos.subitemsRenderInfos.push_back(nullptr);
+			continue; //skip items configured to draw first instance only.
+		}
+
+		ItemRenderInfos* subItemInfos = allocateNode();
+		subItemInfos->item = pageInfos.item->subitems()[i];
+		subItemInfos->itemValue = pageInfos.itemValue.getValue(subItemInfos->item->dataKey());
+		subItemInfos->currentSize = subItemInfos->item->initialSize();
+		subItemInfos->maxSize = subItemInfos->item->maxSize();
+		subItemInfos->rendered = false;
+		subItemInfos->continuationIndex = QVariant();
+		subItemInfos->layoutStatus = Success;
+
+		ItemRenderInfos* previousItemRenderInfos = nullptr;
+
+		if (previousPageInfos != nullptr) {
+			if (previousPageInfos->subitemsRenderInfos.size() > i) {
+				previousItemRenderInfos = previousPageInfos->subitemsRenderInfos[i];
+			}
+		}
+
+		if (previousItemRenderInfos != nullptr) {
+			if (previousItemRenderInfos->layoutStatus == Success) {
+
+				if (previousItemRenderInfos->item != nullptr) {
+					if (previousItemRenderInfos->item->overflowBehavior() != DocumentItem::OverflowBehavior::CopyOnNewPages) {
+						discardNode(subItemInfos);
+						pageInfos.subitemsRenderInfos.push_back(nullptr);
+						continue;
+					}
+				} else {
+					discardNode(subItemInfos);
+					pageInfos.subitemsRenderInfos.push_back(nullptr);
+					continue;
+				}
+			}
+		}
+
+		pageInfos.subitemsRenderInfos.push_back(subItemInfos);
+
+		RenderingStatus itemStatus = layoutItem(*subItemInfos, previousItemRenderInfos);
+
+        if (itemStatus.status == NotAllItemsRendered) {
+            if (subItemInfos->item->overflowBehavior() == DocumentItem::OverflowOnNewPage) {
+                anyItemProgressedRender |= itemStatus.anyItemProgressedRender;
+                hasMoreToRender = true;
+            } else if (subItemInfos->item->overflowBehavior() == DocumentItem::CopyOnNewPages) {
+                anyItemProgressedRender |= itemStatus.anyItemProgressedRender;
+                hasMoreToRender = true;
+            } else {
+				status.status = MissingSpace;
+				reportDiagnostic(MissingSpace, subItemInfos->item, _pagesToWrite, QT_TR_NOOP("Missing space for non-overflowing item: %1"));
+			}
+		} else if (itemStatus.status != Success) {
+			status.status = itemStatus.status;
+        } else {
+            anyItemProgressedRender = true; //an item sucessfully rendered
+        }
+	}
+
+	_pagesToWrite++;
+
+	return status;
+}
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutList(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender) {
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
 	int nItems = itemInfos.item->subitems().size();
@@ -933,8 +2412,6 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutList(ItemRenderInfos&
         renderSize.setHeight(_renderContext.region.height());
     }
 
-	QString message = "";
-
 	int startsId = 0;
 
 	if (previousRender != nullptr) {
@@ -942,8 +2419,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutList(ItemRenderInfos&
 			startsId = previousRender->continuationIndex.toInt();
 
 			if (previousRender->subitemsRenderInfos.isEmpty()) {
-				return RenderingStatus{OtherError,
-							QObject::tr("List with empty non null previous render should not occur").arg(itemInfos.item->objectName())};
+				return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("List with empty non null previous render should not occur"));
 			}
 
 			if (previousRender->subitemsRenderInfos.last()->layoutStatus != NotAllItemsRendered) {
@@ -962,14 +2438,14 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutList(ItemRenderInfos&
 
 	if (startsId >= nItems) {
 		itemInfos.layoutStatus = Success;
-		return RenderingStatus{Success, "", renderSize};
+		return RenderingStatus{Success, QString(), renderSize};
 	}
 
     bool anyItemProgressedRender = false;
 
 	for (int i = startsId; i < nItems; i++) {
 
-		ItemRenderInfos* subItemInfos = new ItemRenderInfos();
+		ItemRenderInfos* subItemInfos = allocateNode();
 		subItemInfos->item = itemInfos.item->subitems()[i];
 
 		if (itemInfos.itemValue.hasArray()) { //in case an array was provided, use the index
@@ -996,6 +2472,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutList(ItemRenderInfos&
             }
         }
 
+		int diagnosticsMark = _diagnostics.size();
 		RenderingStatus layoutStatus = layoutItem(*subItemInfos, previousInfos);
 
 		itemInfos.continuationIndex = i;
@@ -1008,12 +2485,12 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutList(ItemRenderInfos&
 		if (layoutStatus.status == MissingSpace) {
 			if (i == startsId) {
 				itemInfos.layoutStatus = MissingSpace;
-				message = layoutStatus.message +
-						QString("\n Table: %1 missing space to render at least one item").arg(itemInfos.item->objectName());
+				reportDiagnostic(MissingSpace, itemInfos.item, _pagesToWrite, QT_TR_NOOP("List: %1 missing space to render at least one item"));
 			} else {
+				dropMovedItemDiagnostics(diagnosticsMark); //not an error, the item is moved to the next page
 				itemInfos.layoutStatus = NotAllItemsRendered;
 				itemInfos.subitemsRenderInfos.removeLast();
-				delete subItemInfos;
+				discardNode(subItemInfos);
                 itemInfos.continuationIndex = i-1; //if the previous item still has elements to render
 			}
 			break;
@@ -1185,21 +2662,21 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutList(ItemRenderInfos&
 
     renderSize.rwidth() += itemInfos.item->origin().x();
     renderSize.rheight() += itemInfos.item->origin().y();
-    return RenderingStatus{itemInfos.layoutStatus, message, renderSize, anyItemProgressedRender};
+    return RenderingStatus{itemInfos.layoutStatus, QString(), renderSize, anyItemProgressedRender};
 
 }
 
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutFrame(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender) {
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
 	QSizeF itemInitialSize = itemInfos.item->initialSize();
 
     if (itemInitialSize.width() > _renderContext.region.width() or
             itemInitialSize.height() > _renderContext.region.height()) {
-		return RenderingStatus{MissingSpace, QObject::tr("Not enough space to render Frame: %1").arg(itemInfos.item->objectName())};
+		return layoutError(MissingSpace, itemInfos.item, QT_TR_NOOP("Not enough space to render Frame: %1"));
 	}
 
 	int nItems = itemInfos.item->subitems().size();
@@ -1224,11 +2701,11 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutFrame(ItemRenderInfos&
             itemInfos.item->initialSize(),
             itemInfos.item->maxSize()};
 
-	RenderingStatus status{Success, ""};
+	RenderingStatus status{Success};
 
 	for (int i = 0; i < nItems; i++) {
 
-		ItemRenderInfos* subItemInfos = new ItemRenderInfos();
+		ItemRenderInfos* subItemInfos = allocateNode();
 		subItemInfos->item = itemInfos.item->subitems()[i];
 		subItemInfos->itemValue = itemInfos.itemValue.getValue(subItemInfos->item->dataKey());
 		subItemInfos->currentSize = subItemInfos->item->initialSize();
@@ -1250,11 +2727,11 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutFrame(ItemRenderInfos&
 
 				if (previousItemRenderInfos->item != nullptr) {
 					if (previousItemRenderInfos->item->overflowBehavior() != DocumentItem::OverflowBehavior::CopyOnNewPages) {
-						delete subItemInfos;
+						discardNode(subItemInfos);
 						continue;
 					}
 				} else {
-					delete subItemInfos;
+					discardNode(subItemInfos);
 					continue;
 				}
 			}
@@ -1270,10 +2747,6 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutFrame(ItemRenderInfos&
 
 		if (itemStatus.status != Success) {
 			status.status = itemStatus.status;
-			if (!status.message.isEmpty()) {
-				status.message += "\n";
-			}
-			status.message += itemStatus.message;
 		}
 
 		if (subItemInfos->item->posX() + itemStatus.renderSize.width() > renderSize.width()) {
@@ -1294,11 +2767,11 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutFrame(ItemRenderInfos&
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutText(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender) {
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
 	if (_painter == nullptr) {
-		return RenderingStatus{OtherError, QObject::tr("Invalid painter used for layout!")};
+		return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("Invalid painter used for layout!"));
 	}
 
 	QSizeF itemInitialSize = itemInfos.item->initialSize();
@@ -1307,7 +2780,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutText(ItemRenderInfos&
 			itemInitialSize.height() > _renderContext.region.height()) {
 
 		itemInfos.layoutStatus = MissingSpace;
-		return RenderingStatus{MissingSpace, QObject::tr("Not enough space to render Text: %1").arg(itemInfos.item->objectName())};
+		return layoutError(MissingSpace, itemInfos.item, QT_TR_NOOP("Not enough space to render Text: %1"));
 	}
 
 	QVariant variant = itemInfos.itemValue.getValue();
@@ -1358,41 +2831,17 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutText(ItemRenderInfos&
     int flags = alignement | Qt::TextWordWrap;
 
 	QRectF rectangle = QRectF(origin, renderSize);
-    QFontMetricsF fontMetric(font);
 
     qreal lineWidth = rectangle.width();
 
-    int leading = fontMetric.leading();
-    qreal height = 0;
-
-    QStringList lines = text.split("\n");
-
     QTextOption options;
     options.setAlignment(alignement);
 
-    for (QString const& line : qAsConst(lines)) {
-
-        QTextLayout textLayout((line.isEmpty() ? " " : line), font, _painter->device());
-        textLayout.setTextOption(options);
-        textLayout.setCacheEnabled(true);
-        textLayout.beginLayout();
-        while (true) {
-            QTextLine line = textLayout.createLine();
-            if (!line.isValid())
-                break;
-
-            line.setLineWidth(lineWidth);
-            height += leading;
-            line.setPosition(QPointF(0, height));
-            height += line.height();
-        }
-        textLayout.endLayout();
-
-    }
+    qreal height = measureTextHeight(itemInfos.item, text, font, options, lineWidth);
 
     QRectF boundingRect = QRectF(origin, QSizeF(lineWidth, height));
 
-    RenderingStatus status{Success, "", renderSize};
+    RenderingStatus status{Success, QString(), renderSize};
 
 	if (boundingRect.width() > rectangle.width() or boundingRect.height() > rectangle.height()) {
 		//in can the initial size is not enough
@@ -1400,34 +2849,16 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutText(ItemRenderInfos&
 		QSizeF maxRenderSize(itemInfos.item->maxSize());
         QRectF rectangle = QRectF(origin, maxRenderSize);
 
-        lineWidth = rectangle.width();
-        height = 0;
-
-        for (QString const& line : qAsConst(lines)) {
-
-            QTextLayout textLayout((line.isEmpty() ? " " : line), font, _painter->device());
-            textLayout.setTextOption(options);
-            textLayout.setCacheEnabled(true);
-            textLayout.beginLayout();
-            while (true) {
-                QTextLine line = textLayout.createLine();
-                if (!line.isValid())
-                    break;
-
-                line.setLineWidth(lineWidth);
-                height += leading;
-                line.setPosition(QPointF(0, height));
-                height += line.height();
-            }
-            textLayout.endLayout();
-
+        if (rectangle.width() != lineWidth) { //the lines only change with the width
+            lineWidth = rectangle.width();
+            height = measureTextHeight(itemInfos.item, text, font, options, lineWidth);
         }
 
         boundingRect = QRectF(origin, QSizeF(lineWidth, height));
 
 		if (boundingRect.width() > rectangle.width() or boundingRect.height() > rectangle.height()) {
 			status.status = MissingSpace;
-			status.message = QObject::tr("Text from text block %1 overflow").arg(itemInfos.item->objectName());
+			reportDiagnostic(MissingSpace, itemInfos.item, _pagesToWrite, QT_TR_NOOP("Text from text block %1 overflow"));
 		} else {
 			status.renderSize = boundingRect.size();
 		}
@@ -1438,40 +2869,92 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutText(ItemRenderInfos&
 	return status;
 
 }
+qreal DocumentRenderer::measureTextHeight(DocumentItem const* item, QString const& text, QFont const& font, QTextOption const& options, qreal lineWidth) {
+
+	if (_movedRowMeasurements != nullptr) {
+		//the font and options come from the item, they did not change since the previous page.
+		for (TextMeasurement const& measurement : *_movedRowMeasurements) {
+			if (measurement.item == item and measurement.lineWidth == lineWidth and measurement.text == text) {
+				if (_loopDepth > 0) {
+					_rowTextMeasurements.push_back(measurement); //in case the row is moved again
+				}
+				return measurement.height;
+			}
+		}
+	}
+
+	QFontMetricsF fontMetric(font);
+
+	int leading = fontMetric.leading();
+	qreal height = 0;
+
+	QStringList lines = text.split("\n");
+
+	for (QString const& line : qAsConst(lines)) {
+
+		QTextLayout textLayout((line.isEmpty() ? " " : line), font, _painter->device());
+		textLayout.setTextOption(options);
+		textLayout.setCacheEnabled(true);
+		textLayout.beginLayout();
+		_statistics.paragraphsShaped++;
+		while (true) {
+			QTextLine line = textLayout.createLine();
+			if (!line.isValid())
+				break;
+
+			_statistics.linesBroken++;
+
+			line.setLineWidth(lineWidth);
+			height += leading;
+			line.setPosition(QPointF(0, height));
+			height += line.height();
+		}
+		textLayout.endLayout();
+
+	}
+
+	if (_loopDepth > 0) {
+		_rowTextMeasurements.push_back(TextMeasurement{item, lineWidth, height, text}); //kept if the row is moved to the next page
+	}
+
+	return height;
+}
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutImage(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender){
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
 	QSizeF itemInitialSize = itemInfos.item->initialSize();
 
 	if (itemInitialSize.width() > _renderContext.region.width() or
 		itemInitialSize.height() > _renderContext.region.height()) {
-		return RenderingStatus{MissingSpace, QObject::tr("Not enough space to render Image: %1").arg(itemInfos.item->objectName())};
+		return layoutError(MissingSpace, itemInfos.item, QT_TR_NOOP("Not enough space to render Image: %1"));
 	}
 
 	QVariant variant = itemInfos.itemValue.getValue();
 	QImage image;
+	QString path;
 
 	if (variant.isValid()) {
 		if (variant.canConvert<QImage>()) {
 			image = qvariant_cast<QImage>(variant);
 		} else if (variant.canConvert<QString>()) {
-			image = QImage(variant.toString());
+			path = variant.toString();
 		}
 	} else {
-		image = QImage(itemInfos.item->data());
+		path = itemInfos.item->data();
 	}
 
-	if (image.isNull()) {
-		if (variant.canConvert<QString>()) {
-			if (!variant.toString().isEmpty()) {
-				return RenderingStatus{MissingData, QObject::tr("Cannot load data for Image: %1").arg(itemInfos.item->objectName())};
-			}
-		} else {
-			return RenderingStatus{MissingData, QObject::tr("Cannot load data for Image: %1").arg(itemInfos.item->objectName())};
+	if (!path.isEmpty()) {
+		//the file is read and decoded in the background while the layout goes on,
+		//if it cannot be loaded the error is reported by the render pass.
+		//images on pages before the rendered range are never painted, so they are not loaded.
+		if (_pagesToWrite >= _firstPageToRender) {
+			_imagePrefetcher->prefetch(path, itemInfos.currentSize);
 		}
+	} else if (image.isNull() and !variant.canConvert<QString>()) {
+		return layoutError(MissingData, itemInfos.item, QT_TR_NOOP("Cannot load data for Image: %1"));
 	}
 
 	QPointF origin = _renderContext.origin + itemInfos.item->origin();
@@ -1488,50 +2971,65 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutImage(ItemRenderInfos&
 
 	QSizeF renderSize(itemInfos.item->initialSize());
 
-    RenderingStatus status{Success, "", renderSize};
+    RenderingStatus status{Success, QString(), renderSize};
 
 	return status;
 }
 DocumentRenderer::RenderingStatus DocumentRenderer::layoutPlugin(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender) {
 
 	if (_pluginManager == nullptr) {
-		return RenderingStatus{OtherError, QObject::tr("Missing plugin manager")};
+		return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("Missing plugin manager"));
 	}
 
 	RenderPlugin const* plugin = _pluginManager->getPlugin(itemInfos.item->data());
 
 	if (plugin == nullptr) {
-		return RenderingStatus{OtherError, QObject::tr("Requested missing plugin")};
+		return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("Requested missing plugin"));
 	}
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return layoutError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
     QPointF origin = _renderContext.origin + itemInfos.item->origin();
 
 	QSizeF itemInitialSize = itemInfos.item->initialSize();
 
-    QRectF requiredRegion = plugin->getMinimalSpace(QRectF(origin, itemInitialSize), itemInfos.itemValue);
+    QRectF requiredRegion;
+
+    {
+        QMutexLocker locker(_pluginManager->callMutex(plugin));
+
+        PreparedRenderPlugin const* preparedPlugin = dynamic_cast<PreparedRenderPlugin const*>(plugin);
+
+        _statistics.pluginCalls++;
+
+        if (preparedPlugin != nullptr) {
+            itemInfos.pluginPreparedData = _pluginManager->preparedData(itemInfos.item->data(), preparedPlugin, itemInfos.itemValue);
+            requiredRegion = preparedPlugin->getPreparedMinimalSpace(QRectF(origin, itemInitialSize), itemInfos.pluginPreparedData.data());
+        } else {
+            requiredRegion = plugin->getMinimalSpace(QRectF(origin, itemInitialSize), itemInfos.itemValue);
+        }
+    }
 
     itemInitialSize.rheight() = std::max(itemInitialSize.height(), requiredRegion.height());
     itemInitialSize.rwidth() = std::max(itemInitialSize.width(), requiredRegion.width());
 
 	if (itemInitialSize.width() > _renderContext.region.width() or
 		itemInitialSize.height() > _renderContext.region.height()) {
-		return RenderingStatus{MissingSpace, QObject::tr("Not enough space to render Plugin: %1").arg(itemInfos.item->objectName())};
+		return layoutError(MissingSpace, itemInfos.item, QT_TR_NOOP("Not enough space to render Plugin: %1"));
 	}
 
     if (itemInitialSize.width() > itemInfos.maxSize.width()) {
         if (requiredRegion.width() > itemInfos.maxSize.width()) {
-            return RenderingStatus{OtherError, QObject::tr("Mismatch between layout and requested size for Plugin: %1").arg(itemInfos.item->objectName())};
+            return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("Mismatch between layout and requested size for Plugin: %1"));
         }
 		itemInitialSize.rwidth() = itemInfos.maxSize.width();
 	}
 
     if (itemInitialSize.height() > itemInfos.maxSize.height()) {
         if (requiredRegion.height() > itemInfos.maxSize.height()) {
-            return RenderingStatus{OtherError, QObject::tr("Mismatch between layout and requested size for Plugin: %1").arg(itemInfos.item->objectName())};
+            return layoutError(OtherError, itemInfos.item, QT_TR_NOOP("Mismatch between layout and requested size for Plugin: %1"));
         }
 		itemInitialSize.rheight() = itemInfos.maxSize.height();
 	}
@@ -1554,20 +3052,74 @@ DocumentRenderer::RenderingStatus DocumentRenderer::layoutPlugin(ItemRenderInfos
 
 	QPointF delta = requiredRegion.bottomRight() - origin;
 
-    return{Success, "", QSizeF(delta.x(), delta.y())};
+    return{Success, QString(), QSizeF(delta.x(), delta.y())};
+}
+
+
+DocumentRenderer::RenderingStatus DocumentRenderer::renderLayoutItems(QVector<ItemRenderInfos*> const& layout) {
+
+	RenderingStatus status{Success};
+
+	for (ItemRenderInfos* item : layout) {
+
+		if (item == nullptr) {
+			continue;
+		}
+
+		RenderingStatus itemStatus = renderItem(*item);
+
+		if (itemStatus.status != Success) {
+			status.status = itemStatus.status;
+		}
+	}
+
+	return status;
 }
 
+DocumentRenderer::RenderingStatus DocumentRenderer::renderPageRange(QVector<ItemRenderInfos*> const& layout, int firstPage, int lastPage) {
+
+	if (firstPage <= 0 and lastPage < 0) {
+		return renderLayoutItems(layout);
+	}
+
+	QVector<ItemRenderInfos*> pages;
+	QVector<QPointF> offsets;
+	collectLayoutPages(layout, pages, &offsets);
+
+	if (firstPage >= pages.size()) {
+		return RenderingStatus{MissingData, QObject::tr("Page range %1-%2 is out of the document (%3 pages)").arg(firstPage).arg(lastPage).arg(pages.size())};
+	}
+
+	int last = (lastPage < 0) ? pages.size()-1 : std::min(lastPage, pages.size()-1);
+
+	RenderingStatus status{Success};
+
+	for (int i = firstPage; i <= last; i++) {
+
+		//the parents of the pages (loops and conditions) do not paint anything themselves, only their offset is needed.
+		RenderOffsetScope offsetScope(_renderOffset, offsets[i]);
+		RenderingStatus pageStatus = renderItem(*pages[i]);
+
+		if (pageStatus.status != Success) {
+			status.status = pageStatus.status;
+		}
+	}
+
+	return status;
+}
 
 DocumentRenderer::RenderingStatus DocumentRenderer::renderItem(ItemRenderInfos& itemInfos) {
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return renderError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
 	if (!itemInfos.toRender) {
 		return RenderingStatus{Success}; //just skip rendering the item.
 	}
 
+	RenderTracer::Scope traceScope(_tracer, "render", itemInfos.item, _pagesWritten+1);
+
 	switch(itemInfos.item->getType()) {
 	case DocumentItem::Type::Condition:
 		return renderCondition(itemInfos);
@@ -1586,15 +3138,17 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderItem(ItemRenderInfos&
 	case DocumentItem::Type::Plugin:
 		return renderPlugin(itemInfos);
 	case DocumentItem::Type::Invalid:
-		return RenderingStatus{OtherError, QObject::tr("Invalid block : %1").arg(itemInfos.item->objectName())};
+		return renderError(OtherError, itemInfos.item, QT_TR_NOOP("Invalid block : %1"));
 	}
 
-	return RenderingStatus{OtherError, QObject::tr("Unknown error for block : %1").arg(itemInfos.item->objectName())};
+	return renderError(OtherError, itemInfos.item, QT_TR_NOOP("Unknown error for block : %1"));
 }
 
 
 DocumentRenderer::RenderingStatus DocumentRenderer::renderCondition(ItemRenderInfos& itemInfos) {
 
+	RenderOffsetScope offsetScope(_renderOffset, itemInfos.subitemsOffset);
+
 	for (ItemRenderInfos* subitemInfos : itemInfos.subitemsRenderInfos) {
 		if (subitemInfos == nullptr) {
 			continue;
@@ -1606,12 +3160,14 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderCondition(ItemRenderIn
 		}
 	}
 
-	return RenderingStatus{Success, "", itemInfos.currentSize};
+	return RenderingStatus{Success, QString(), itemInfos.currentSize};
 
 }
 DocumentRenderer::RenderingStatus DocumentRenderer::renderLoop(ItemRenderInfos& itemInfos) {
 
-	RenderingStatus status{Success, ""};
+	RenderingStatus status{Success};
+
+	RenderOffsetScope offsetScope(_renderOffset, itemInfos.subitemsOffset);
 
 	for (ItemRenderInfos* subitemInfos : itemInfos.subitemsRenderInfos) {
 		if (subitemInfos == nullptr) {
@@ -1621,10 +3177,6 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderLoop(ItemRenderInfos&
 
 		if (itemStatus.status != Success) {
 			status.status = itemStatus.status;
-			if (!status.message.isEmpty()) {
-				status.message += "\n";
-			}
-			status.message += itemStatus.message;
 		}
 	}
 
@@ -1634,7 +3186,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderLoop(ItemRenderInfos&
 DocumentRenderer::RenderingStatus DocumentRenderer::renderPage(ItemRenderInfos& itemInfos) {
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return renderError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
 	QPageSize pageSize(itemInfos.currentSize, QPageSize::Unit::Point);
@@ -1646,7 +3198,11 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderPage(ItemRenderInfos&
 		_writer->newPage(); //create a new page in the writer.
 	}
 
-	RenderingStatus status{Success, ""};
+	dispatchThreadSafePlugins(itemInfos, _renderOffset);
+
+	RenderingStatus status{Success};
+
+	RenderOffsetScope offsetScope(_renderOffset, itemInfos.subitemsOffset);
 
 	for (ItemRenderInfos* subitemInfos : itemInfos.subitemsRenderInfos) {
 		if (subitemInfos == nullptr) {
@@ -1656,10 +3212,6 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderPage(ItemRenderInfos&
 
 		if (itemStatus.status != Success) {
 			status.status = itemStatus.status;
-			if (!status.message.isEmpty()) {
-				status.message += "\n";
-			}
-			status.message += itemStatus.message;
 		}
 	}
 
@@ -1667,12 +3219,16 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderPage(ItemRenderInfos&
         _pagesWritten++;
     }
 
+	collectPluginRenders();
+
 	return status;
 
 }
 DocumentRenderer::RenderingStatus DocumentRenderer::renderList(ItemRenderInfos& itemInfos) {
 
-	RenderingStatus status{Success, ""};
+	RenderingStatus status{Success};
+
+	RenderOffsetScope offsetScope(_renderOffset, itemInfos.subitemsOffset);
 
 	for (ItemRenderInfos* subitemInfos : itemInfos.subitemsRenderInfos) {
 		if (subitemInfos == nullptr) {
@@ -1682,10 +3238,6 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderList(ItemRenderInfos&
 
 		if (itemStatus.status != Success) {
 			status.status = itemStatus.status;
-			if (!status.message.isEmpty()) {
-				status.message += "\n";
-			}
-			status.message += itemStatus.message;
 		}
 	}
 
@@ -1694,9 +3246,9 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderList(ItemRenderInfos&
 }
 DocumentRenderer::RenderingStatus DocumentRenderer::renderFrame(ItemRenderInfos& itemInfos) {
 
-	RenderingStatus status{Success, ""};
+	RenderingStatus status{Success};
 
-	QRectF rect(itemInfos.currentOrigin, itemInfos.currentSize);
+	QRectF rect(itemInfos.currentOrigin + _renderOffset, itemInfos.currentSize);
 
 	if (itemInfos.item->fillColor().isValid()) {
 		_painter->fillRect(rect, itemInfos.item->fillColor());
@@ -1722,6 +3274,8 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderFrame(ItemRenderInfos&
 		_painter->setPen(oldPen);
 	}
 
+	RenderOffsetScope offsetScope(_renderOffset, itemInfos.subitemsOffset);
+
 	for (ItemRenderInfos* subitemInfos : itemInfos.subitemsRenderInfos) {
 		if (subitemInfos == nullptr) {
 			continue;
@@ -1730,10 +3284,6 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderFrame(ItemRenderInfos&
 
 		if (itemStatus.status != Success) {
 			status.status = itemStatus.status;
-			if (!status.message.isEmpty()) {
-				status.message += "\n";
-			}
-			status.message += itemStatus.message;
 		}
 	}
 
@@ -1744,11 +3294,11 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderFrame(ItemRenderInfos&
 DocumentRenderer::RenderingStatus DocumentRenderer::renderText(ItemRenderInfos& itemInfos) {
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return renderError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
 	}
 
 	if (_painter == nullptr) {
-		return RenderingStatus{OtherError, QObject::tr("Invalid painter used for rendering!")};
+		return renderError(OtherError, itemInfos.item, QT_TR_NOOP("Invalid painter used for rendering!"));
 	}
 
 	QSizeF itemSize = itemInfos.currentSize;
@@ -1762,7 +3312,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderText(ItemRenderInfos&
 		text = itemInfos.item->data();
 	}
 
-	QPointF origin = itemInfos.currentOrigin;
+	QPointF origin = itemInfos.currentOrigin + _renderOffset;
 
 	QSizeF renderSize = itemInfos.currentSize;
 
@@ -1813,11 +3363,14 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderText(ItemRenderInfos&
         textLayout.setTextOption(options);
         textLayout.setCacheEnabled(true);
         textLayout.beginLayout();
+        _statistics.paragraphsShaped++;
         while (true) {
             QTextLine line = textLayout.createLine();
             if (!line.isValid())
                 break;
 
+            _statistics.linesBroken++;
+
             line.setLineWidth(lineWidth);
             height += leading;
             line.setPosition(QPointF(0, height));
@@ -1831,11 +3384,11 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderText(ItemRenderInfos&
 
     QRectF boundingRect(origin, QSizeF(lineWidth, height));
 
-	RenderingStatus status{Success, "", boundingRect.size()};
+	RenderingStatus status{Success, QString(), boundingRect.size()};
 
 	if (boundingRect.width() > rectangle.width() or boundingRect.height() > rectangle.height()) {
 		status.status = MissingSpace;
-		status.message = QObject::tr("Text from text block %1 overflow").arg(itemInfos.item->objectName());
+		reportDiagnostic(MissingSpace, itemInfos.item, _pagesWritten, QT_TR_NOOP("Text from text block %1 overflow"));
 	}
 
 	return status;
@@ -1844,11 +3397,11 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderText(ItemRenderInfos&
 DocumentRenderer::RenderingStatus DocumentRenderer::renderImage(ItemRenderInfos& itemInfos) {
 
 	if (itemInfos.item == nullptr) {
-        return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+        return renderError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
     }
 
     if (_painter == nullptr) {
-        return RenderingStatus{OtherError, QObject::tr("Invalid painter used for rendering!")};
+        return renderError(OtherError, itemInfos.item, QT_TR_NOOP("Invalid painter used for rendering!"));
     }
 
 	QVariant variant = itemInfos.itemValue.getValue();
@@ -1858,39 +3411,23 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderImage(ItemRenderInfos&
         if (variant.canConvert<QImage>()) {
             image = qvariant_cast<QImage>(variant);
         } else if (variant.canConvert<QString>()) {
-			QString path = variant.toString();
-
-			if (path.toLower().endsWith(".svg")) {
-				//ensure svg files are rendered with enough resolution
-				QSvgRenderer renderer(path);
-				renderer.setAspectRatioMode(Qt::KeepAspectRatio);
-
-				QSize targetSize = 300./72.*itemInfos.currentSize.toSize();
-
-				image = QImage(targetSize, QImage::Format_ARGB32);
-				image.fill(QColor(255,255,255,0));
-
-				QPainter painter(&image);
-				renderer.render(&painter, QRectF(QPointF(0,0), targetSize));
-			} else {
-				image = QImage(path);
-			}
+			image = _imagePrefetcher->image(variant.toString(), itemInfos.currentSize);
         }
     } else {
-		image = QImage(itemInfos.item->data());
+		image = _imagePrefetcher->image(itemInfos.item->data(), itemInfos.currentSize);
     }
 
     if (image.isNull()) {
 		if (variant.canConvert<QString>()) {
 			if (!variant.toString().isEmpty()) {
-				return RenderingStatus{MissingData, QObject::tr("Cannot load data for Image: %1").arg(itemInfos.item->objectName())};
+				return renderError(MissingData, itemInfos.item, QT_TR_NOOP("Cannot load data for Image: %1"));
 			}
 		} else {
-			return RenderingStatus{MissingData, QObject::tr("Cannot load data for Image: %1").arg(itemInfos.item->objectName())};
+			return renderError(MissingData, itemInfos.item, QT_TR_NOOP("Cannot load data for Image: %1"));
 		}
     }
 
-	QPointF origin = itemInfos.currentOrigin;
+	QPointF origin = itemInfos.currentOrigin + _renderOffset;
 
 	QSizeF renderSize = itemInfos.currentSize;
 
@@ -1898,7 +3435,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderImage(ItemRenderInfos&
 	QSizeF posDelta(0,0);
 
 	if (renderSize.width() <= 0 or renderSize.height() <= 0 or imSize.width() <= 0 or imSize.height() <= 0) {
-		return RenderingStatus {Success, "", QSizeF(0,0)};;
+		return RenderingStatus {Success, QString(), QSizeF(0,0)};;
 	}
 
 	double imAspectRatio = imSize.width()/imSize.height();
@@ -1930,7 +3467,7 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderImage(ItemRenderInfos&
 	QRectF rectangle = QRectF(origin, renderSize);
     _painter->drawImage(rectangle, image);
 
-	RenderingStatus status{Success, "", rectangle.size() + posDelta};
+	RenderingStatus status{Success, QString(), rectangle.size() + posDelta};
 
     return status;
 
@@ -1939,21 +3476,106 @@ DocumentRenderer::RenderingStatus DocumentRenderer::renderImage(ItemRenderInfos&
 DocumentRenderer::RenderingStatus DocumentRenderer::renderPlugin(ItemRenderInfos& itemInfos) {
 
 	if (_pluginManager == nullptr) {
-		return RenderingStatus{OtherError, QObject::tr("Missing plugin manager")};
+		return renderError(OtherError, itemInfos.item, QT_TR_NOOP("Missing plugin manager"));
 	}
 
 	RenderPlugin const* plugin = _pluginManager->getPlugin(itemInfos.item->data());
 
 	if (plugin == nullptr) {
-		return RenderingStatus{OtherError, QObject::tr("Requested missing plugin")};
+		return renderError(OtherError, itemInfos.item, QT_TR_NOOP("Requested missing plugin"));
 	}
 
 	if (itemInfos.item == nullptr) {
-		return RenderingStatus{MissingModel, QObject::tr("Invalid item requested!")};
+		return renderError(MissingModel, itemInfos.item, QT_TR_NOOP("Invalid item requested!"));
+	}
+
+	PluginRenderJob* job = _pendingPluginRenders.take(&itemInfos);
+
+	if (job != nullptr) { //the item has already been drawn on a worker thread
+		job->waitForDone();
+
+		_painter->drawPicture(QPointF(0,0), job->picture());
+		RenderingStatus status = job->status();
+
+		delete job;
+		return pluginStatus(status, itemInfos.item);
 	}
 
-	return plugin->renderItem(QRectF(itemInfos.currentOrigin, itemInfos.currentSize), *_painter, itemInfos.itemValue);
+	_statistics.pluginCalls++;
+
+	QMutexLocker locker(_pluginManager->callMutex(plugin));
+	RenderingStatus status = callPluginRender(plugin,
+											  QRectF(itemInfos.currentOrigin + _renderOffset, itemInfos.currentSize),
+											  *_painter,
+											  itemInfos.itemValue,
+											  itemInfos.pluginPreparedData);
+
+	return pluginStatus(status, itemInfos.item);
+}
+
+void DocumentRenderer::dispatchThreadSafePlugins(ItemRenderInfos& itemInfos, QPointF const& offset) {
+
+	if (_pluginManager == nullptr or _painter == nullptr or itemInfos.item == nullptr) {
+		return;
+	}
+
+	if (!itemInfos.toRender) {
+		return;
+	}
+
+	if (itemInfos.item->getType() == DocumentItem::Plugin) {
+
+		RenderPlugin const* plugin = _pluginManager->getPlugin(itemInfos.item->data());
+
+		if (plugin == nullptr or !plugin->isThreadSafe()) {
+			return;
+		}
+
+		if (_pendingPluginRenders.contains(&itemInfos)) {
+			return;
+		}
+
+		PluginRenderJob* job = new PluginRenderJob(plugin,
+												   QRectF(itemInfos.currentOrigin + offset, itemInfos.currentSize),
+												   itemInfos.itemValue,
+												   itemInfos.pluginPreparedData,
+												   _tracer,
+												   itemInfos.item,
+												   _pagesWritten+1,
+												   _painter);
+		_pendingPluginRenders.insert(&itemInfos, job);
+		pluginPool()->start(job);
+		_statistics.pluginCalls++;
+
+		return;
+	}
+
+	for (ItemRenderInfos* subitemInfos : qAsConst(itemInfos.subitemsRenderInfos)) {
+		if (subitemInfos == nullptr) {
+			continue;
+		}
+		dispatchThreadSafePlugins(*subitemInfos, offset + itemInfos.subitemsOffset);
+	}
+}
+
+QThreadPool* DocumentRenderer::pluginPool() {
+
+	//not the global pool, the renderer itself might run in it and would then wait for jobs queued behind it.
+	if (_pluginPool.isNull()) {
+		_pluginPool = QSharedPointer<QThreadPool>(new QThreadPool());
+	}
+
+	return _pluginPool.data();
+}
+
+void DocumentRenderer::collectPluginRenders() {
+
+	for (PluginRenderJob* job : qAsConst(_pendingPluginRenders)) {
+		job->waitForDone();
+		delete job;
+	}
 
+	_pendingPluginRenders.clear();
 }
 
 } // namespace AutoQuill
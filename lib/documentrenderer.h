@@ -5,22 +5,106 @@
 #include <QPoint>
 #include <QSize>
 #include <QVector>
+#include <QHash>
+#include <QSharedPointer>
 
 class QPainter;
 class QPdfWriter;
 class QIODevice;
+class QThreadPool;
+class QFont;
+class QTextOption;
 
 #include "./documentitem.h"
 #include "./documentdatainterface.h"
+#include "./imageprefetcher.h"
+#include "./rendertracer.h"
 
 namespace AutoQuill {
 
 class DocumentTemplate;
 class DocumentDataInterface;
 class RenderPluginManager;
+class PluginPreparedData;
+class LayoutCache;
+class OutputCache;
 
 struct ItemRenderInfos;
 
+/*!
+ * \brief The DocumentLayout class own the pages produced by a layout.
+ *
+ * The class is implicitly shared: copies are cheap and refer to the same items, which are deleted along with the last copy.
+ * Rendering never modifies a layout, so a single layout can be consumed by several outputs (pdf, images, preview),
+ * including at the same time by renderers running in different threads.
+ *
+ * Pay attention, the ItemRenderInfos in the layout keep a reference to the DocumentTemplate, so you need to ensure the
+ * document template is not destroyed before you are done using the layout!
+ */
+class DocumentLayout
+{
+public:
+
+	static constexpr quint32 BinaryMagic = 0x4151544c; //"AQTL"
+	static constexpr quint16 BinaryVersion = 2;
+
+	DocumentLayout();
+	/*!
+	 * \brief DocumentLayout build a layout from a list of items, taking ownership of them.
+	 */
+	explicit DocumentLayout(QVector<ItemRenderInfos*> const& items);
+
+	inline int size() const {
+		return _data->items.size();
+	}
+	inline bool isEmpty() const {
+		return _data->items.isEmpty();
+	}
+	inline ItemRenderInfos* const& operator[](int i) const {
+		return _data->items.at(i);
+	}
+	inline QVector<ItemRenderInfos*> const& items() const {
+		return _data->items;
+	}
+	inline QVector<ItemRenderInfos*>::const_iterator begin() const {
+		return _data->items.constBegin();
+	}
+	inline QVector<ItemRenderInfos*>::const_iterator end() const {
+		return _data->items.constEnd();
+	}
+
+	/*!
+	 * \brief encapsulateToBinary encode the layout, so it can be rendered later or in another process.
+	 * \return the encoded layout, starting with BinaryMagic and BinaryVersion.
+	 *
+	 * The geometry, the status and continuation state of the items and the scalar values read by the items are saved,
+	 * the items are referred to by their position in the template. Structured values (maps and arrays) and the data
+	 * prepared by the plugins are not saved, use isSerializable to check if a layout can be decoded as is.
+	 */
+	QByteArray encapsulateToBinary() const;
+	/*!
+	 * \brief isSerializable tell if encapsulateToBinary keeps everything needed to render the layout.
+	 * \return false if the layout contains plugin items, or items rendered from a structured value or from a value QDataStream cannot write.
+	 */
+	bool isSerializable() const;
+	/*!
+	 * \brief configureFromBinary replace the layout by an encoded one.
+	 * \param data the encoded layout
+	 * \param docTemplate the template the layout was computed for.
+	 * \return true on success, false if the data is invalid or does not match the template (the layout is then left empty).
+	 */
+	bool configureFromBinary(QByteArray const& data, DocumentTemplate const& docTemplate);
+
+protected:
+
+	struct Data {
+		~Data();
+		QVector<ItemRenderInfos*> items;
+	};
+
+	QSharedPointer<Data> _data;
+};
+
 class DocumentRenderer
 {
 public :
@@ -32,12 +116,79 @@ public :
 		MissingModel,
 		MissingData,
 		MissingSpace,
-		OtherError
+		OtherError,
+		MemoryBudgetExceeded //the layout would use more memory than the budget set with setMemoryBudget
+	};
+
+	/*!
+	 * \brief The RenderStatistics struct count the work done by a layout or a render.
+	 *
+	 * Times are in nanoseconds. The cpu time is the one of the whole process, so it includes the worker threads.
+	 */
+	struct RenderStatistics {
+		RenderStatistics();
+
+		RenderStatistics& operator+=(RenderStatistics const& other);
+
+		qint64 nodesAllocated; //number of ItemRenderInfos created by the layout
+		qint64 paragraphsShaped; //number of text paragraphs laid out
+		qint64 linesBroken; //number of text lines created while laying out the paragraphs
+		qint64 imagesDecoded;
+		qint64 imageBytesRead;
+		qint64 pluginCalls;
+		qint64 pagesProduced; //pages laid out for a layout, pages written for a render
+		qint64 bytesWritten;
+		qint64 peakMemoryBytes; //estimated peak memory used by the layout tree, the image cache and the rasterized pages
+		qint64 layoutCacheHits; //layouts loaded from the layout cache instead of being computed
+		qint64 outputCacheHits; //documents copied from the output cache instead of being rendered
+		qint64 layoutWallNs;
+		qint64 layoutCpuNs;
+		qint64 renderWallNs;
+		qint64 renderCpuNs;
 	};
 
+	/*!
+	 * \brief The Diagnostic struct describe an error met during a layout or a render, or a warning (with the code Success).
+	 *
+	 * Diagnostics are recorded as a code and an item reference, the text is only built when it is requested.
+	 */
+	struct Diagnostic {
+		Status code;
+		DocumentItem const* item; //the item concerned, can be null
+		int page; //index of the page being laid out or rendered (starting at 0), -1 if unknown
+		char const* text; //untranslated message, %1 is replaced by the name of the item, %2 and %3 by the arguments
+		QString detail; //formatted message, used if text is null
+		QVariantList arguments; //values inserted in the text, only converted to strings when the text is built
+
+		QString toString() const;
+	};
+
+	/*!
+	 * \brief The TextMeasurement struct keep the height of a text measured while laying out a loop row.
+	 *
+	 * The measurements of a row moved to the next page are kept with the loop, see ItemRenderInfos::movedRowMeasurements.
+	 */
+	struct TextMeasurement {
+		DocumentItem const* item;
+		qreal lineWidth;
+		qreal height;
+		QString text;
+	};
+
+	/*!
+	 * \brief diagnosticsText format a list of diagnostics, one per line.
+	 */
+	static QString diagnosticsText(QVector<Diagnostic> const& diagnostics);
+
+    /*!
+     * \brief The RenderingStatus struct is returned by every layout and render function.
+     *
+     * Internally, only the status code is passed around, the errors are recorded as Diagnostic.
+     * The public layout and render functions attach the diagnostics, and fill the message of the failed status.
+     */
     struct RenderingStatus {
         RenderingStatus(Status p_status = OtherError,
-                        QString p_message = "",
+                        QString const& p_message = QString(),
                         QSizeF p_renderSize = QSize(0,0),
                         bool p_anyItemProgressedRender = false) :
             status(p_status),
@@ -48,7 +199,7 @@ public :
 
         }
         RenderingStatus(Status p_status,
-                        QString p_message,
+                        QString const& p_message,
                         bool p_anyItemProgressedRender) :
             status(p_status),
             message(p_message),
@@ -61,11 +212,14 @@ public :
 		QString message;
 		QSizeF renderSize;
         bool anyItemProgressedRender;
+		QSharedPointer<const RenderStatistics> statistics; //only set by the public layout and render functions.
+		QSharedPointer<const QVector<Diagnostic>> diagnostics; //only set by the public layout and render functions, if any.
     };
 
 	struct LayoutResults {
-		QVector<ItemRenderInfos*> layout;
+		DocumentLayout layout;
 		RenderingStatus status;
+		RenderStatistics statistics;
 	};
 
     DocumentRenderer(DocumentTemplate const& docTemplate);
@@ -75,64 +229,231 @@ public :
 	 * \brief layout layout the items and return a list of rendered pages
 	 * \param dataInterface the data interface for the document
 	 * \param pluginManager the plugin manager to use for the plugins.
-	 * \return the LayoutResults, containing the list of pages, as well as the layout status
+	 * \param maxPages if positive, the layout stops once this number of pages is reached (e.g. to preview the first pages).
+	 * \return the LayoutResults, containing the list of pages, as well as the layout status and statistics
      *
      * Pay attention, the ItemRenderInfos in the layout keep a reference to the DocumentTemplate, so you need to ensure the
      * document template is not destroyed before you are done using the layout!
+     *
+     * The layout can be rendered as many times as needed, with any of the render functions.
      */
-    LayoutResults layout(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager);
+    LayoutResults layout(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, int maxPages = -1);
     /*!
      * \brief layoutHeadless does the same thing as layout, but using an external QPainter. Use this if you are using the renderer to paint to external QtSurfaces
      * \param dataInterface the data interface to use
      * \param pluginManager the plugin manager to use
      * \param painterOverride the painter to use
-     * \return the LayoutResults, containing the list of pages, as well as the layout status
+     * \param maxPages if positive, the layout stops once this number of pages is reached.
+     * \return the LayoutResults, containing the list of pages, as well as the layout status and statistics
      *
      * Pay attention, the ItemRenderInfos in the layout keep a reference to the DocumentTemplate, so you need to ensure the
      * document template is not destroyed before you are done using the layout!
      */
-    LayoutResults layoutHeadless(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, QPainter* painterOverride);
+    LayoutResults layoutHeadless(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, QPainter* painterOverride, int maxPages = -1);
+
+    /*!
+     * \brief beginLayout start laying out a document one page at a time, see nextPage.
+     * \param dataInterface the data interface to use (it must outlive the layout)
+     * \param pluginManager the plugin manager to use
+     * \param painterOverride the painter used to measure the items (it must outlive the layout)
+     * \return a rendering status, Success if the layout can start.
+     *
+     * Starting a layout abandon the one in progress, if any.
+     */
+    RenderingStatus beginLayout(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, QPainter* painterOverride);
+    /*!
+     * \brief nextPage layout the next page of the document started with beginLayout
+     * \return the LayoutResults, with a layout containing the page, or an empty layout once the document is done or if an error occurred.
+     *
+     * Only the state needed to continue the document (the last page) is kept between calls, so viewers and streaming outputs
+     * can pull the pages they need without laying out the whole document. Each page can be rendered with the render functions.
+     * Top level items which are not pages (e.g. loops of pages) are laid out at once when reached, then their pages are given one by one.
+     * The statistics cover the whole layout so far.
+     */
+    LayoutResults nextPage();
+    /*!
+     * \brief hasNextPage tell if nextPage might still give a page.
+     */
+    bool hasNextPage() const;
+    /*!
+     * \brief endLayout release the state of the layout started with beginLayout (the pages already given are not affected).
+     */
+    void endLayout();
+
 	RenderingStatus render(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, QIODevice* device);
 	RenderingStatus render(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, QString const& filename);
 
+	/*!
+	 * \brief renderPages render only a range of pages of a document
+	 * \param dataInterface the data interface for the document
+	 * \param pluginManager the plugin manager to use
+	 * \param device the device to render to
+	 * \param firstPage the index of the first page to render (starting at 0)
+	 * \param lastPage the index of the last page to render (included), clamped to the last page of the document.
+	 * \return a rendering status
+	 *
+	 * The layout stops after the last requested page, and the images of the pages before the range are not loaded.
+	 * The output cache is not used, as it store complete documents.
+	 */
+	RenderingStatus renderPages(DocumentDataInterface const* dataInterface,
+								RenderPluginManager const& pluginManager,
+								QIODevice* device,
+								int firstPage,
+								int lastPage);
+	RenderingStatus renderPages(DocumentDataInterface const* dataInterface,
+								RenderPluginManager const& pluginManager,
+								QString const& filename,
+								int firstPage,
+								int lastPage);
+
     /*!
      * \brief render render the elements in a given layout
-     * \param layout the layout to render (the function will not take ownership and will not delete the layout)
+     * \param layout the layout to render (the layout is not modified and can be rendered again)
      * \param pluginManager the plugin manager to use
      * \param device the device to render to
      * \return a rendering status
+     *
+     * A renderer can only render one output at a time, use one renderer per output to render a layout concurrently.
      */
-    RenderingStatus render(QVector<ItemRenderInfos*> const& layout,
+    RenderingStatus render(DocumentLayout const& layout,
                            RenderPluginManager const& pluginManager,
                            QIODevice* device);
     /*!
      * \brief render render the elements in a given layout
-     * \param layout the layout to render (the function will not take ownership and will not delete the layout)
+     * \param layout the layout to render (the layout is not modified and can be rendered again)
      * \param pluginManager the plugin manager to use
      * \param filename the file to render to
      * \return a rendering status
      */
-    RenderingStatus render(QVector<ItemRenderInfos*> const& layout,
+    RenderingStatus render(DocumentLayout const& layout,
                            RenderPluginManager const& pluginManager,
                            QString const& filename);
 
+    /*!
+     * \brief renderPages render a range of pages of a layout
+     * \param layout the layout to render (the layout is not modified and can be rendered again)
+     * \param pluginManager the plugin manager to use
+     * \param device the device to render to
+     * \param firstPage the index of the first page to render (starting at 0)
+     * \param lastPage the index of the last page to render (included), clamped to the last page of the layout.
+     * \return a rendering status
+     */
+    RenderingStatus renderPages(DocumentLayout const& layout,
+                                RenderPluginManager const& pluginManager,
+                                QIODevice* device,
+                                int firstPage,
+                                int lastPage);
+
     /*!
      * \brief renderItem render an item using a specific QPainter
      * \param itemInfos the item to render
      * \param painterOverride the painter to paint to
+     * \param parentsOffset the pending offset of the parents of the item, as given by collectLayoutPages.
      * \return a rendering status
      *
      * This function is meant to be used for previewing items, not to render the document.
      * It will not assume there is a paged device underneath, so you need to ensure
-     * only one page is rendered.
+     * only one page is rendered. The item is drawn at its currentOrigin plus parentsOffset.
+     */
+    RenderingStatus renderItemToExternalPainter(ItemRenderInfos& itemInfos, QPainter* painterOverride, QPointF const& parentsOffset = QPointF());
+
+    /*!
+     * \brief renderToImages render each page of a layout to an image file
+     * \param layout the layout to render (the layout is not modified and can be rendered again)
+     * \param pluginManager the plugin manager to use
+     * \param filePattern the path of the image files, where %1 is replaced by the page number (starting at 1).
+     * \param dpi the resolution of the images
+     * \param format the image format (e.g. "png" or "webp"), if empty the format is deduced from the file suffix.
+     * \return a rendering status
+     *
+     * The pages are painted in pageless mode, in parallel on a pool of worker threads, so the same layout can be
+     * used to render both the pdf and the page thumbnails.
+     */
+    RenderingStatus renderToImages(DocumentLayout const& layout,
+                                   RenderPluginManager const& pluginManager,
+                                   QString const& filePattern,
+                                   qreal dpi = 72,
+                                   QByteArray const& format = QByteArray());
+
+    /*!
+     * \brief imagePrefetchStatistics give the statistics of the background image loader since the last layout.
+     * \return the statistics, including the time the render pass spent waiting for images.
+     */
+    ImagePrefetcher::Statistics imagePrefetchStatistics() const;
+
+    /*!
+     * \brief setImageCacheLimit set the memory the prefetched images can use, see ImagePrefetcher::setMemoryLimit.
+     */
+    void setImageCacheLimit(qint64 bytes);
+
+    /*!
+     * \brief setTracer set a tracer recording the layout and render time of each item.
+     * \param tracer the tracer (not owned by the renderer), or nullptr to disable tracing (the default).
+     */
+    void setTracer(RenderTracer* tracer);
+    inline RenderTracer* tracer() const {
+        return _tracer;
+    }
+
+    /*!
+     * \brief setLayoutCache set a cache for the layouts computed by layout and render (with a data interface).
+     * \param cache the cache (not owned by the renderer), or nullptr to disable caching (the default).
+     *
+     * Only complete layouts are cached, for data interfaces which provide a content hash.
+     * Layouts loaded from the cache do not carry structured values nor the data prepared by the plugins (see DocumentLayout::encapsulateToBinary).
+     */
+    void setLayoutCache(LayoutCache* cache);
+    inline LayoutCache* layoutCache() const {
+        return _layoutCache;
+    }
+
+    /*!
+     * \brief setOutputCache set a cache for the documents rendered by render with a data interface.
+     * \param cache the cache (not owned by the renderer), or nullptr to disable caching (the default).
+     *
+     * With a cache, the document is laid out first, on a separate device, while recording the data values read.
+     * If a document with the same content hash was already rendered, it is copied to the output device, otherwise
+     * the document is rendered in memory, then written to the device and to the cache.
+     *
+     * When the layout comes from the layout cache, no value is read, so the content hash use the hash of the whole data instead.
+     */
+    void setOutputCache(OutputCache* cache);
+    inline OutputCache* outputCache() const {
+        return _outputCache;
+    }
+
+    /*!
+     * \brief setMemoryBudget set the memory a layout is allowed to use.
+     * \param bytes the budget, in bytes, or a non positive value to disable it (the default).
+     *
+     * The memory is estimated from the layout items alive and the images in the image cache. Once it exceed the budget,
+     * the layout stops with the MemoryBudgetExceeded status. The peak memory usage is reported in the RenderStatistics.
      */
-    RenderingStatus renderItemToExternalPainter(ItemRenderInfos& itemInfos, QPainter* painterOverride);
+    void setMemoryBudget(qint64 bytes);
+    inline qint64 memoryBudget() const {
+        return _memoryBudget;
+    }
 
+    /*!
+     * \brief collectLayoutPages list the pages of a layout which are to be rendered, in order.
+     * \param offsets if not null, receive the pending offset of the parents of each page (see ItemRenderInfos::translate).
+     */
+    static void collectLayoutPages(QVector<ItemRenderInfos*> const& layout, QVector<ItemRenderInfos*> & pages, QVector<QPointF>* offsets = nullptr);
     static int getLayoutNPages(QVector<ItemRenderInfos*> const& layout);
     static ItemRenderInfos* getLayoutNthPage(QVector<ItemRenderInfos*> const& layout, int n);
 
 protected :
 
+	/*!
+	 * \brief DocumentRenderer build a renderer sharing the image prefetcher of another one, e.g. for the raster workers.
+	 */
+	DocumentRenderer(DocumentTemplate const& docTemplate, QSharedPointer<ImagePrefetcher> const& imagePrefetcher);
+
+	static void collectLayoutPages(QVector<ItemRenderInfos*> const& layout,
+								   QVector<ItemRenderInfos*> & pages,
+								   QVector<QPointF>* offsets,
+								   QPointF const& parentsOffset);
+
 	struct RenderContext {
 		DocumentItem::Direction direction;
         QPointF origin;
@@ -164,12 +485,38 @@ protected :
 	RenderingStatus layoutCondition(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender = nullptr);
 	RenderingStatus layoutLoop(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender = nullptr);
 	RenderingStatus layoutPage(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender = nullptr, QVector<ItemRenderInfos*>* targetItemPool = nullptr);
+	/*!
+	 * \brief layoutPageInstance layout the content of a single page, continuing previousPageInfos if not null.
+	 * \param hasMoreToRender set to true if some items need to continue on a new page.
+	 * \param anyItemProgressedRender set to true if some items made progress on the page.
+	 */
+	RenderingStatus layoutPageInstance(ItemRenderInfos& pageInfos,
+									   ItemRenderInfos* previousPageInfos,
+									   bool isFirst,
+									   bool & hasMoreToRender,
+									   bool & anyItemProgressedRender);
 	RenderingStatus layoutList(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender = nullptr);
 	RenderingStatus layoutFrame(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender = nullptr);
 	RenderingStatus layoutText(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender = nullptr);
+	/*!
+	 * \brief measureTextHeight break the paragraphs of a text into lines
+	 * \return the height of the text.
+	 *
+	 * A loop row moved to the next page is not broken into lines again when the width of its texts did not change,
+	 * the heights measured on the previous page are reused.
+	 */
+	qreal measureTextHeight(DocumentItem const* item, QString const& text, QFont const& font, QTextOption const& options, qreal lineWidth);
 	RenderingStatus layoutImage(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender = nullptr);
 	RenderingStatus layoutPlugin(ItemRenderInfos& itemInfos, ItemRenderInfos* previousRender = nullptr);
 
+	/*!
+	 * \brief renderLayoutItems render the top level items of a layout with the current painter.
+	 */
+	RenderingStatus renderLayoutItems(QVector<ItemRenderInfos*> const& layout);
+	/*!
+	 * \brief renderPageRange render the pages firstPage to lastPage of a layout, or all the items if lastPage is negative.
+	 */
+	RenderingStatus renderPageRange(QVector<ItemRenderInfos*> const& layout, int firstPage, int lastPage);
 	RenderingStatus renderItem(ItemRenderInfos& itemInfos);
 
 	RenderingStatus renderCondition(ItemRenderInfos& itemInfos);
@@ -181,15 +528,135 @@ protected :
 	RenderingStatus renderImage(ItemRenderInfos& itemInfos);
 	RenderingStatus renderPlugin(ItemRenderInfos& itemInfos);
 
+	class PluginRenderJob;
+	class PageRasterJob;
+
+	/*!
+	 * \brief allocateNode create a new ItemRenderInfos, accounting for its memory.
+	 */
+	ItemRenderInfos* allocateNode();
+	/*!
+	 * \brief discardNode delete an ItemRenderInfos (and its subitems) the layout do not need.
+	 */
+	void discardNode(ItemRenderInfos* node);
+
+	qint64 estimatedMemoryUsage(qint64 nNodes) const;
+	bool memoryBudgetExceeded() const;
+	void updatePeakMemory(qint64 nNodes);
+
+	/*!
+	 * \brief dispatchThreadSafePlugins start drawing the thread safe plugins items of a subtree on worker threads.
+	 *
+	 * Each plugin item is drawn into its own QPicture, which renderPlugin then replays on the painter.
+	 * \param offset the offset accumulated from the parents of the item, see ItemRenderInfos::translate.
+	 */
+	void dispatchThreadSafePlugins(ItemRenderInfos& itemInfos, QPointF const& offset);
+	/*!
+	 * \brief pluginPool get the pool running the plugin jobs, created on first use.
+	 */
+	QThreadPool* pluginPool();
+	/*!
+	 * \brief collectPluginRenders wait for and discard the plugin drawings which have not been used.
+	 */
+	void collectPluginRenders();
+
 	QPainter* _painter;
 	QPdfWriter* _writer;
 	int _pagesWritten;
 	int _pagesToWrite;
+	int _maxPages; //stop the layout after this number of pages, if positive
+	int _firstPageToRender; //images on the pages before are not prefetched by the layout
+
+	inline bool pageLimitReached() const {
+		return _maxPages > 0 and _pagesToWrite >= _maxPages;
+	}
 
 	DocumentTemplate const* _docTemplate;
 
 	RenderPluginManager const* _pluginManager;
 	RenderContext _renderContext;
+	QPointF _renderOffset; //pending offset of the parents of the item being rendered, see ItemRenderInfos::translate
+
+	QVector<TextMeasurement> _rowTextMeasurements; //texts measured in the loop rows being laid out, see layoutLoop
+	QVector<TextMeasurement> const* _movedRowMeasurements; //texts measured in the row being laid out again after a page break
+	int _loopDepth; //number of loops being laid out
+
+	QSharedPointer<ImagePrefetcher> _imagePrefetcher;
+	QHash<ItemRenderInfos const*, PluginRenderJob*> _pendingPluginRenders;
+	QSharedPointer<QThreadPool> _pluginPool; //shared with the page raster renderers
+
+	RenderTracer* _tracer;
+	LayoutCache* _layoutCache;
+	OutputCache* _outputCache;
+
+	RenderingStatus renderWithOutputCache(DocumentDataInterface const* dataInterface, RenderPluginManager const& pluginManager, QIODevice* device);
+	/*!
+	 * \brief renderDocument layout and render the pages firstPage to lastPage of a document (all the pages if lastPage is negative).
+	 */
+	RenderingStatus renderDocument(DocumentDataInterface const* dataInterface, QIODevice* device, int firstPage, int lastPage);
+	/*!
+	 * \brief renderLayout render the pages firstPage to lastPage of a layout (all the pages if lastPage is negative).
+	 */
+	RenderingStatus renderLayout(DocumentLayout const& layout, QIODevice* device, int firstPage, int lastPage);
+
+	QByteArray layoutCacheKey(DocumentDataInterface const* dataInterface, int maxPages) const;
+
+	/*!
+	 * \brief addImageStatistics add the images decoded since a snapshot of the prefetcher statistics.
+	 */
+	void addImageStatistics(ImagePrefetcher::Statistics const& since);
+	/*!
+	 * \brief attachResults attach a copy of the current statistics and diagnostics to a status, and its message if it failed.
+	 */
+	void attachResults(RenderingStatus & status) const;
+
+	/*!
+	 * \brief reportDiagnostic record a diagnostic, the text is only formatted if the diagnostics are requested.
+	 */
+	void reportDiagnostic(Status code, DocumentItem const* item, int page, char const* text, QString const& detail = QString());
+	void reportDiagnostic(Status code, DocumentItem const* item, int page, char const* text, QVariantList const& arguments);
+	void recordDiagnostic(Diagnostic const& diagnostic);
+	/*!
+	 * \brief dropMovedItemDiagnostics drop the errors reported since mark by an item which is moved to the next page.
+	 *
+	 * The warnings are kept, and are not reported again when the item is laid out on the next page.
+	 */
+	void dropMovedItemDiagnostics(int mark);
+	/*!
+	 * \brief layoutError record a diagnostic on the page being laid out and return the matching status.
+	 */
+	RenderingStatus layoutError(Status code, DocumentItem const* item, char const* text);
+	/*!
+	 * \brief renderError record a diagnostic on the page being rendered and return the matching status.
+	 */
+	RenderingStatus renderError(Status code, DocumentItem const* item, char const* text);
+	/*!
+	 * \brief pluginStatus record the message of a failed plugin call as a diagnostic.
+	 */
+	RenderingStatus pluginStatus(RenderingStatus const& status, DocumentItem const* item);
+
+	RenderStatistics _statistics;
+	QVector<Diagnostic> _diagnostics; //diagnostics of the current layout or render, parents drop the ones of the errors they recover from
+	QVector<Diagnostic> _movedDiagnostics; //warnings of items moved to the next page, not to be reported twice
+
+	struct LayoutCursor {
+		DocumentDataInterface const* dataInterface; //null if no layout is in progress
+		RenderPluginManager const* pluginManager;
+		QPainter* painter;
+		int nextItem; //next top level item of the template
+		DocumentLayout currentPage; //last page given by nextPage, kept for its continuation state
+		bool pageHasMore; //currentPage need to continue on a new page
+		QVector<ItemRenderInfos*> pendingPages; //pages of a top level item which is not a page, not given yet
+		int nPages; //pages given so far
+		RenderStatistics statistics; //statistics since beginLayout, the renderer statistics are reset by other calls
+		QVector<Diagnostic> movedDiagnostics; //warnings of the items moved to the next page
+	};
+
+	LayoutCursor _cursor;
+
+	qint64 _memoryBudget;
+	qint64 _liveNodes; //layout items created by the current layout and not discarded
+	qint64 _peakLiveNodes;
 };
 
 struct ItemRenderInfos {
@@ -207,6 +674,7 @@ struct ItemRenderInfos {
     DocumentValue itemValue;
     DocumentItem* item;
     QPointF currentOrigin;
+    QPointF subitemsOffset; //translation of the subitems which has not been applied to their currentOrigin yet, see translate.
     QSizeF currentSize;
     QSizeF maxSize;
     DocumentRenderer::Status layoutStatus;
@@ -214,11 +682,17 @@ struct ItemRenderInfos {
     bool toRender;
     bool rendered;
     QVariant continuationIndex;
+    QVector<DocumentRenderer::TextMeasurement> movedRowMeasurements; //texts measured in the loop row after continuationIndex, which was moved to the next page.
+    QSharedPointer<const PluginPreparedData> pluginPreparedData; //state computed by a PreparedRenderPlugin during layout, reused for rendering.
     QVector<ItemRenderInfos*> subitemsRenderInfos;
 
     /*!
          * \brief translate translate the current item, and all subitems
          * \param delta the delta to apply to the origin.
+         *
+         * The translation of the subitems is only recorded in subitemsOffset, so moving a subtree does not
+         * touch its subitems. The renderer accumulate the offsets of the parents when drawing, the actual
+         * position of a subitem is its currentOrigin plus the subitemsOffset of all its parents.
          */
     void translate(QPointF const& delta);
 };
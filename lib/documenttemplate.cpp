@@ -8,10 +8,16 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
 #include <QMimeData>
 
 namespace AutoQuill {
 
+constexpr char const* DocumentTemplate::BinarySuffix;
+constexpr quint32 DocumentTemplate::BinaryMagic;
+constexpr quint16 DocumentTemplate::BinaryVersion;
+
 DocumentTemplate::DocumentTemplate(QObject *parent) :
     QObject(parent),
     _currentSavePath("")
@@ -24,6 +30,10 @@ bool DocumentTemplate::removeSubItem(int index) {
 		return false;
 	}
 
+	if (_items[index] != nullptr) {
+		unindexReferences(_items[index]);
+	}
+
 	_items.removeAt(index);
 	return true;
 }
@@ -68,9 +78,8 @@ QJsonValue DocumentTemplate::encapsulateToJson() const {
 
     return blocks;
 }
-bool DocumentTemplate::configureFromJson(QJsonValue const& value) {
-	bool status = true;
-	Q_EMIT aboutToBeReset();
+
+void DocumentTemplate::clearItems() {
 
 	for (DocumentItem* item : qAsConst(_items)) {
 		if (item == nullptr) {
@@ -82,6 +91,14 @@ bool DocumentTemplate::configureFromJson(QJsonValue const& value) {
 	}
 
 	_items.clear();
+	_refIndex.clear();
+}
+
+bool DocumentTemplate::configureFromJson(QJsonValue const& value) {
+	bool status = true;
+	Q_EMIT aboutToBeReset();
+
+	clearItems();
 
 	if (!value.isArray()) {
 		status = false;
@@ -104,18 +121,92 @@ bool DocumentTemplate::configureFromJson(QJsonValue const& value) {
 	return status;
 }
 
-bool DocumentTemplate::saveTo(QString const& path) {
+QByteArray DocumentTemplate::encapsulateToBinary() const {
 
-    QJsonValue val = encapsulateToJson();
+	QByteArray datas;
+	QDataStream out(&datas, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_0);
+	out.setFloatingPointPrecision(QDataStream::DoublePrecision);
 
-    QJsonDocument doc;
-    if (val.isObject()) {
-        doc.setObject(val.toObject());
-    } else if (val.isArray()) {
-        doc.setArray(val.toArray());
-    }
+	out << BinaryMagic << BinaryVersion;
+
+	quint32 nItems = 0;
+
+	for (DocumentItem* item : _items) {
+		if (item != nullptr) {
+			nItems++;
+		}
+	}
+
+	out << nItems;
+
+	for (DocumentItem* item : _items) {
+		if (item == nullptr) {
+			continue;
+		}
+
+		item->encapsulateToBinary(out);
+	}
+
+	return datas;
+}
+
+bool DocumentTemplate::configureFromBinary(QByteArray const& data) {
+
+	QDataStream in(data);
+	in.setVersion(QDataStream::Qt_5_0);
+	in.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+	quint32 magic = 0;
+	quint16 version = 0;
+	quint32 nItems = 0;
+
+	in >> magic >> version >> nItems;
+
+	if (in.status() != QDataStream::Ok or magic != BinaryMagic or version > BinaryVersion) {
+		return false;
+	}
+
+	Q_EMIT aboutToBeReset();
+
+	clearItems();
+
+	for (quint32 i = 0; i < nItems and in.status() == QDataStream::Ok; i++) {
+		DocumentItem* item = DocumentItem::buildFromBinary(in);
+
+		if (item == nullptr) {
+			continue;
+		}
 
-    QByteArray datas = doc.toJson();
+		insertSubItem(item);
+	}
+
+	Q_EMIT reseted();
+	return in.status() == QDataStream::Ok;
+}
+
+bool DocumentTemplate::saveTo(QString const& path, Format format) {
+
+	if (format == Auto) {
+		format = (QFileInfo(path).suffix().toLower() == BinarySuffix) ? Binary : Json;
+	}
+
+	QByteArray datas;
+
+	if (format == Binary) {
+		datas = encapsulateToBinary();
+	} else {
+		QJsonValue val = encapsulateToJson();
+
+		QJsonDocument doc;
+		if (val.isObject()) {
+			doc.setObject(val.toObject());
+		} else if (val.isArray()) {
+			doc.setArray(val.toArray());
+		}
+
+		datas = doc.toJson();
+	}
 
     QFile out(path);
 
@@ -141,13 +232,21 @@ bool DocumentTemplate::loadFrom(QString const& path) {
 		return false;
 	}
 
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+	if (!file.open(QIODevice::ReadOnly)) {
 		return false;
 	}
 
 	QByteArray datas = file.readAll();
 	file.close();
 
+	QDataStream magicStream(datas);
+	quint32 magic = 0;
+	magicStream >> magic;
+
+	if (magic == BinaryMagic) {
+		return configureFromBinary(datas);
+	}
+
 	QJsonParseError errors;
 	QJsonDocument doc = QJsonDocument::fromJson(datas, &errors);
 
@@ -169,23 +268,55 @@ bool DocumentTemplate::loadFrom(QString const& path) {
 
 DocumentItem* DocumentTemplate::findByReference(QString const& ref) const {
 
-	QStringList splitted = ref.split(REF_URL_SEP);
+	auto it = _refIndex.find(ref);
 
-	DocumentItem* ret = nullptr;
+	if (it == _refIndex.end()) {
+		return nullptr;
+	}
 
-	for (DocumentItem* item : qAsConst(_items)) {
-		if (item == nullptr) {
-			continue;
-		}
+	DocumentItem* ret = it.value().data();
+
+	if (ret == nullptr) { //the item has been deleted since the reference was built.
+		_refIndex.erase(it);
+	}
+
+	return ret;
+}
+
+void DocumentTemplate::unindexReferences(DocumentItem* item) {
+
+	if (_refIndex.isEmpty() or item->_ref.isEmpty()) {
+		return; //items without ref, and their subitems, cannot be indexed.
+	}
 
-		ret = item->findByReference(splitted);
+	QStringList refs;
+	refs << item->_ref;
 
-		if (ret != nullptr) {
-			break;
+	for (DocumentItem* pItem = item->parentDocumentItem(); pItem != nullptr; pItem = pItem->parentDocumentItem()) {
+		if (pItem->_ref.isEmpty()) {
+			return;
 		}
+		refs.prepend(pItem->_ref);
 	}
 
-	return ret;
+	unindexReferences(item, refs.join(REF_URL_SEP));
+}
+
+void DocumentTemplate::indexReference(QString const& ref, DocumentItem* item) const {
+	_refIndex.insert(ref, item);
+}
+
+void DocumentTemplate::unindexReferences(DocumentItem* item, QString const& ref) {
+
+	_refIndex.remove(ref);
+
+	for (DocumentItem* subitem : qAsConst(item->_items)) {
+		if (subitem == nullptr or subitem->_ref.isEmpty()) {
+			continue;
+		}
+
+		unindexReferences(subitem, ref + REF_URL_SEP + subitem->_ref);
+	}
 }
 
 DocumentTemplateModel::DocumentTemplateModel(QObject* parent) :
@@ -245,20 +376,12 @@ QModelIndex DocumentTemplateModel::parent(const QModelIndex &index) const {
 		return QModelIndex();
 	}
 
-	if (qobject_cast<DocumentTemplate*>(parentParentObj) != nullptr) {
-		int row = _root->children().indexOf(pItem);
-		return createIndex(row,0,pItem);
-	}
-
-	DocumentItem* ppItem = qobject_cast<DocumentItem*>(parentParentObj);
-
-	if (ppItem == nullptr) {
+	if (qobject_cast<DocumentTemplate*>(parentParentObj) == nullptr and
+			qobject_cast<DocumentItem*>(parentParentObj) == nullptr) {
 		return QModelIndex();
 	}
 
-	int row = ppItem->subitems().indexOf(pItem);
-
-	return createIndex(row,0,pItem);
+	return createIndex(pItem->row(),0,pItem);
 
 }
 
@@ -501,27 +624,13 @@ QMimeData* DocumentTemplateModel::mimeData(const QModelIndexList &indexes) const
 
 QModelIndex DocumentTemplateModel::indexFromItem(DocumentItem* item) {
 
-	DocumentItem* parentItem = qobject_cast<DocumentItem*>(item->parent());
+	int row = item->row();
 
-	if (parentItem == nullptr) {
-		int row = _root->subitems().indexOf(item);
-
-		if (row < 0 or row >= _root->subitems().size()) {
-			return QModelIndex();
-		} else {
-			return createIndex(row,0,item);
-		}
-	}
-
-	int row = parentItem->subitems().indexOf(item);
-
-	if (row < 0 or row >= parentItem->subitems().size()) {
+	if (row < 0) {
 		return QModelIndex();
-	} else {
-		return createIndex(row,0,item);
 	}
 
-	return QModelIndex();
+	return createIndex(row,0,item);
 }
 
 void DocumentTemplateModel::insertItem(QModelIndex const& parent, int pos, DocumentItem* item) {
@@ -539,7 +648,7 @@ void DocumentTemplateModel::insertItem(QModelIndex const& parent, int pos, Docum
 	int nItems = _root->subitems().size();
 
 	if (target != nullptr) {
-		target->subitems().size();
+		nItems = target->subitems().size();
 	}
 
 	int tPos = pos;
@@ -572,14 +681,7 @@ void DocumentTemplateModel::removeItem(QModelIndex const& itemIndex) {
 
 	QModelIndex parent = itemIndex.parent();
 
-	int row = 0;
-
-	if (parent == QModelIndex()) {
-		row = _root->subitems().indexOf(target);
-	} else {
-		DocumentItem* pItem = reinterpret_cast<DocumentItem*>(parent.internalPointer());
-		row = pItem->subitems().indexOf(target);
-	}
+	int row = target->row();
 
 	int pRows = rowCount(parent);
 	if (row < 0 or row >= pRows) {
@@ -672,10 +774,14 @@ void DocumentTemplateModel::moveItem(QModelIndex const& itemIndex, int pos, QMod
 	}
 
 
+	//the reference of the item is only unique among its siblings, so it is rebuilt in its new parent.
+	_root->unindexReferences(item);
+	item->_ref.clear();
+
 	beginMoveRows(oldParent, oldRow, oldRow, parent, pos);
 	sourcePlace->removeAt(itemIndex.row());
 
-	targetPlace->insert(pos, item);
+	targetPlace->insert(aPos, item);
 
 	if (newPItem != nullptr) {
 		item->setParent(newPItem);
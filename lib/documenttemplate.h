@@ -3,6 +3,8 @@
 
 #include <QObject>
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QPointer>
 
 #include <QJsonValue>
 
@@ -20,6 +22,21 @@ public:
 	 */
 	static constexpr char REF_URL_SEP = '/';
 
+	/*!
+	 * \brief The Format enum list the formats a template can be saved to.
+	 *
+	 * Auto select the binary format for files with the BinarySuffix suffix, and json otherwise.
+	 */
+	enum Format {
+		Auto,
+		Json,
+		Binary
+	};
+
+	static constexpr char const* BinarySuffix = "aqtb";
+	static constexpr quint32 BinaryMagic = 0x41515442; //"AQTB"
+	static constexpr quint16 BinaryVersion = 1;
+
 	explicit DocumentTemplate(QObject* parent = nullptr);
 
 
@@ -34,7 +51,21 @@ public:
     QJsonValue encapsulateToJson() const;
 	bool configureFromJson(QJsonValue const& value);
 
-	bool saveTo(QString const& path);
+	/*!
+	 * \brief encapsulateToBinary encode the template in the compact binary format.
+	 * \return the encoded template, starting with BinaryMagic and BinaryVersion.
+	 */
+	QByteArray encapsulateToBinary() const;
+	bool configureFromBinary(QByteArray const& data);
+
+	bool saveTo(QString const& path, Format format = Auto);
+	/*!
+	 * \brief loadFrom load a template from a file
+	 * \param path the path of the file
+	 * \return true on success
+	 *
+	 * The format (json or binary) is detected from the content of the file.
+	 */
 	bool loadFrom(QString const& path);
 
     inline QString currentSavePath() const {
@@ -47,8 +78,24 @@ public:
         }
     }
 
+	/*!
+	 * \brief findByReference find an item from a reference built with DocumentItem::buildRef
+	 * \param ref the reference
+	 * \return the item, or nullptr if no item in the template has this reference.
+	 *
+	 * References are registered in an index when they are built, so the lookup does not walk the template.
+	 */
 	DocumentItem* findByReference(QString const& ref) const;
 
+	/*!
+	 * \brief unindexReferences remove the references to an item and its subitems from the reference index.
+	 * \param item the item
+	 *
+	 * This has to be called before the item is detached from its parent, as the path of the references
+	 * depends on the parent. New references will be indexed the next time DocumentItem::buildRef is called.
+	 */
+	void unindexReferences(DocumentItem* item);
+
 Q_SIGNALS:
 
 	void aboutToBeReset();
@@ -56,10 +103,18 @@ Q_SIGNALS:
 
 protected:
 
+	void clearItems();
+
+	void indexReference(QString const& ref, DocumentItem* item) const;
+	void unindexReferences(DocumentItem* item, QString const& ref);
+
 	QList<DocumentItem*> _items;
 
+	mutable QHash<QString, QPointer<DocumentItem>> _refIndex;
+
     QString _currentSavePath;
 
+	friend class DocumentItem;
 	friend class DocumentTemplateModel;
 };
 
@@ -0,0 +1,228 @@
+#include "imageprefetcher.h"
+
+#include <QFile>
+#include <QColor>
+#include <QPainter>
+#include <QSvgRenderer>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+
+namespace AutoQuill {
+
+constexpr qreal ImagePrefetcher::svgResolution;
+constexpr qint64 ImagePrefetcher::defaultMemoryLimit;
+
+namespace {
+
+QSize svgTargetSize(QSizeF const& displaySize) {
+	return (ImagePrefetcher::svgResolution/72.*displaySize).toSize();
+}
+
+} // namespace
+
+class ImagePrefetcher::LoadJob : public QRunnable
+{
+public:
+	LoadJob(ImagePrefetcher* prefetcher, QString const& path, QSizeF const& displaySize) :
+		_prefetcher(prefetcher),
+		_path(path),
+		_displaySize(displaySize)
+	{
+
+	}
+
+	void run() override {
+		qint64 bytesRead = 0;
+		QByteArray svgData;
+		QImage image = ImagePrefetcher::loadImage(_path, _displaySize, &bytesRead, &svgData);
+		_prefetcher->storeImage(_path, image, svgData, bytesRead);
+	}
+
+protected:
+	ImagePrefetcher* _prefetcher;
+	QString _path;
+	QSizeF _displaySize;
+};
+
+ImagePrefetcher::ImagePrefetcher() :
+	_cacheBytes(0),
+	_memoryLimit(defaultMemoryLimit)
+{
+	//loading images is mostly waiting for the storage, so use more threads than cores.
+	_pool.setMaxThreadCount(std::max(4, QThread::idealThreadCount()));
+	resetStatistics();
+}
+
+ImagePrefetcher::~ImagePrefetcher() {
+	_pool.waitForDone();
+}
+
+void ImagePrefetcher::setMemoryLimit(qint64 bytes) {
+	QMutexLocker locker(&_mutex);
+	_memoryLimit = bytes;
+}
+
+qint64 ImagePrefetcher::memoryLimit() const {
+	QMutexLocker locker(&_mutex);
+	return _memoryLimit;
+}
+
+void ImagePrefetcher::prefetch(QString const& path, QSizeF const& displaySize) {
+
+	if (path.isEmpty()) {
+		return;
+	}
+
+	QMutexLocker locker(&_mutex);
+
+	if (_cache.contains(path)) {
+		return;
+	}
+
+	if (_memoryLimit >= 0 and _cacheBytes >= _memoryLimit) {
+		return; //the render pass will load the image
+	}
+
+	_cache.insert(path, Entry{false, QImage(), QByteArray()});
+	_statistics.requested++;
+
+	locker.unlock();
+
+	_pool.start(new LoadJob(this, path, displaySize));
+}
+
+QImage ImagePrefetcher::image(QString const& path, QSizeF const& displaySize) {
+
+	if (path.isEmpty()) {
+		return QImage();
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QMutexLocker locker(&_mutex);
+
+	if (!_cache.contains(path)) {
+		locker.unlock();
+
+		qint64 bytesRead = 0;
+		QImage image = loadImage(path, displaySize, &bytesRead);
+
+		locker.relock();
+		_statistics.decoded++;
+		_statistics.bytesRead += bytesRead;
+		_statistics.stalls++;
+		_statistics.stallTimeNs += timer.nsecsElapsed();
+		return image;
+	}
+
+	if (_cache.value(path).ready) {
+		_statistics.hits++;
+	} else {
+		while (!_cache.value(path).ready) {
+			_imageReady.wait(&_mutex);
+		}
+
+		_statistics.stalls++;
+		_statistics.stallTimeNs += timer.nsecsElapsed();
+	}
+
+	Entry entry = _cache.value(path);
+	locker.unlock();
+
+	if (entry.svgData.isEmpty() or entry.image.size() == svgTargetSize(displaySize)) {
+		return entry.image;
+	}
+
+	//displayed at another size than it was prefetched for, rasterize the svg again.
+	return rasterizeSvg(entry.svgData, displaySize);
+}
+
+void ImagePrefetcher::clear() {
+
+	_pool.waitForDone();
+
+	QMutexLocker locker(&_mutex);
+	_cache.clear();
+	_cacheBytes = 0;
+}
+
+ImagePrefetcher::Statistics ImagePrefetcher::statistics() const {
+	QMutexLocker locker(&_mutex);
+	return _statistics;
+}
+
+qint64 ImagePrefetcher::memoryUsage() const {
+	QMutexLocker locker(&_mutex);
+	return _cacheBytes;
+}
+
+void ImagePrefetcher::resetStatistics() {
+	QMutexLocker locker(&_mutex);
+	_statistics = Statistics{0, 0, 0, 0, 0, 0};
+}
+
+QImage ImagePrefetcher::loadImage(QString const& path, QSizeF const& displaySize, qint64* bytesRead, QByteArray* svgData) {
+
+	QFile file(path);
+
+	if (!file.open(QFile::ReadOnly)) {
+		return QImage();
+	}
+
+	QByteArray data = file.readAll();
+	file.close();
+
+	if (bytesRead != nullptr) {
+		*bytesRead = data.size();
+	}
+
+	if (!path.toLower().endsWith(".svg")) {
+		return QImage::fromData(data);
+	}
+
+	if (svgData != nullptr) {
+		*svgData = data;
+	}
+
+	return rasterizeSvg(data, displaySize);
+}
+
+QImage ImagePrefetcher::rasterizeSvg(QByteArray const& data, QSizeF const& displaySize) {
+
+	//ensure svg files are rendered with enough resolution
+	QSvgRenderer renderer(data);
+	renderer.setAspectRatioMode(Qt::KeepAspectRatio);
+
+	QSize targetSize = svgTargetSize(displaySize);
+
+	if (targetSize.isEmpty()) {
+		return QImage();
+	}
+
+	QImage image(targetSize, QImage::Format_ARGB32);
+	image.fill(QColor(255,255,255,0));
+
+	QPainter painter(&image);
+	renderer.render(&painter, QRectF(QPointF(0,0), targetSize));
+
+	return image;
+}
+
+void ImagePrefetcher::storeImage(QString const& path, QImage const& image, QByteArray const& svgData, qint64 bytesRead) {
+
+	QMutexLocker locker(&_mutex);
+
+	_statistics.decoded++;
+	_statistics.bytesRead += bytesRead;
+
+	_cacheBytes += static_cast<qint64>(image.bytesPerLine())*image.height() + svgData.size();
+	_cache[path] = Entry{true, image, svgData};
+	_imageReady.wakeAll();
+}
+
+} // namespace AutoQuill
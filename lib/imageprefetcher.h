@@ -0,0 +1,132 @@
+#ifndef IMAGEPREFETCHER_H
+#define IMAGEPREFETCHER_H
+
+#include <QImage>
+#include <QString>
+#include <QSize>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+
+namespace AutoQuill {
+
+/*!
+ * \brief The ImagePrefetcher class load the images of a document in the background.
+ *
+ * The layout request the images as soon as it knows their path, the files are then read, decoded
+ * and (for svg files) rasterized on a pool of worker threads while the rest of the document is laid out.
+ * When the render pass needs an image, it only has to wait if the image is not ready yet.
+ *
+ * Images are cached by path. Svg files keep their content along with the rasterized image, so an image displayed
+ * at another size than the one it was prefetched for is rasterized again without reading the file.
+ * Once the cached images use more than memoryLimit, new images are not prefetched anymore
+ * and the render pass load them itself, so image heavy documents do not keep all their images in memory.
+ */
+class ImagePrefetcher
+{
+public:
+
+	struct Statistics {
+		int requested; //number of images queued for loading
+		int hits; //images which were ready when the render pass needed them
+		int stalls; //images the render pass had to wait for (or load itself)
+		qint64 stallTimeNs; //total time the render pass spent waiting for images
+		int decoded; //number of image files read and decoded (or rasterized)
+		qint64 bytesRead; //total size of the image files read
+	};
+
+	/*!
+	 * \brief svgResolution is the resolution (in dpi) svg images are rasterized at.
+	 */
+	static constexpr qreal svgResolution = 300.;
+
+	/*!
+	 * \brief defaultMemoryLimit is the memory the cached images can use by default, in bytes.
+	 */
+	static constexpr qint64 defaultMemoryLimit = 256*1024*1024;
+
+	ImagePrefetcher();
+	~ImagePrefetcher();
+
+	/*!
+	 * \brief setMemoryLimit set the memory the cached images can use before prefetching stops
+	 * \param bytes the limit, in bytes, or a negative value for no limit.
+	 */
+	void setMemoryLimit(qint64 bytes);
+	qint64 memoryLimit() const;
+
+	/*!
+	 * \brief prefetch queue an image for loading
+	 * \param path the path of the image file
+	 * \param displaySize the size the image will be displayed at, in points (used to rasterize vector images).
+	 *
+	 * Nothing is done if the image is already cached or the cache is full.
+	 */
+	void prefetch(QString const& path, QSizeF const& displaySize);
+
+	/*!
+	 * \brief image get an image, waiting for it if it is still loading
+	 * \param path the path of the image file
+	 * \param displaySize the size the image will be displayed at, in points.
+	 * \return the image (a null image if the file could not be read).
+	 *
+	 * If the image was never queued, it is loaded synchronously.
+	 */
+	QImage image(QString const& path, QSizeF const& displaySize);
+
+	/*!
+	 * \brief clear wait for the pending loads and drop all the cached images.
+	 */
+	void clear();
+
+	Statistics statistics() const;
+	void resetStatistics();
+
+	/*!
+	 * \brief memoryUsage give the memory used by the cached images, in bytes.
+	 */
+	qint64 memoryUsage() const;
+
+	/*!
+	 * \brief loadImage read and decode an image file
+	 * \param path the path of the image file
+	 * \param displaySize the size the image will be displayed at, in points (used to rasterize vector images).
+	 * \param bytesRead if not null, receive the number of bytes read from the file.
+	 * \param svgData if not null, receive the content of the file if it is an svg file.
+	 * \return the image (a null image if the file could not be read).
+	 */
+	static QImage loadImage(QString const& path, QSizeF const& displaySize, qint64* bytesRead = nullptr, QByteArray* svgData = nullptr);
+
+	/*!
+	 * \brief rasterizeSvg render an svg image at svgResolution
+	 * \param data the content of the svg file
+	 * \param displaySize the size the image will be displayed at, in points.
+	 */
+	static QImage rasterizeSvg(QByteArray const& data, QSizeF const& displaySize);
+
+protected:
+
+	class LoadJob;
+
+	struct Entry {
+		bool ready;
+		QImage image;
+		QByteArray svgData; //content of the file for svg images, empty otherwise
+	};
+
+	void storeImage(QString const& path, QImage const& image, QByteArray const& svgData, qint64 bytesRead);
+
+	mutable QMutex _mutex;
+	QWaitCondition _imageReady;
+	QHash<QString, Entry> _cache;
+	qint64 _cacheBytes;
+	qint64 _memoryLimit;
+	Statistics _statistics;
+
+	QThreadPool _pool;
+};
+
+} // namespace AutoQuill
+
+#endif // IMAGEPREFETCHER_H
@@ -1,6 +1,8 @@
 #include "jsondocumentdatainterface.h"
 
 #include <QJsonArray>
+#include <QJsonDocument>
+#include <QCryptographicHash>
 
 namespace AutoQuill {
 
@@ -75,4 +77,9 @@ DocumentValue JsonDocumentDataInterface::getValue(QString const& key) const {
 
 }
 
+QByteArray JsonDocumentDataInterface::contentHash() const {
+	//the keys of json objects are sorted, so the same data always give the same text.
+	return QCryptographicHash::hash(QJsonDocument(_data).toJson(QJsonDocument::Compact), QCryptographicHash::Sha256);
+}
+
 } // namespace AutoQuill
@@ -13,6 +13,7 @@ public:
     JsonDocumentDataInterface(QJsonObject const& data, QObject* parent = nullptr);
 
 	virtual DocumentValue getValue(QString const& key) const override;
+	virtual QByteArray contentHash() const override;
 
 protected:
 
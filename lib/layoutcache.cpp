@@ -0,0 +1,140 @@
+#include "layoutcache.h"
+
+#include "documenttemplate.h"
+#include "documentitem.h"
+#include "documentdatainterface.h"
+#include "documentrenderer.h"
+#include "renderplugin.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+namespace AutoQuill {
+
+constexpr char const* LayoutCache::FileSuffix;
+
+namespace {
+
+/*!
+ * \brief addPlugins hash the name and version of the plugins used by a list of items and their subitems.
+ */
+void addPlugins(QCryptographicHash & hash, QList<DocumentItem*> const& items, RenderPluginManager const* pluginManager, QSet<QString> & plugins) {
+
+	for (DocumentItem const* item : items) {
+
+		if (item->getType() == DocumentItem::Plugin and !plugins.contains(item->data())) {
+			plugins.insert(item->data());
+
+			RenderPlugin const* plugin = (pluginManager != nullptr) ? pluginManager->getPlugin(item->data()) : nullptr;
+
+			hash.addData(QString("plugin:%1:%2\n").arg(item->data(), (plugin != nullptr) ? plugin->version() : QString("missing")).toUtf8());
+		}
+
+		addPlugins(hash, item->subitems(), pluginManager, plugins);
+	}
+}
+
+} // namespace
+
+LayoutCache::LayoutCache(QString const& directory) :
+	_directory(directory),
+	_statistics{0, 0, 0}
+{
+	QDir().mkpath(_directory);
+}
+
+QByteArray LayoutCache::key(DocumentTemplate const& docTemplate,
+							 DocumentDataInterface const& dataInterface,
+							 QByteArray const& context,
+							 RenderPluginManager const* pluginManager) {
+
+	QByteArray dataHash = dataInterface.contentHash();
+
+	if (dataHash.isEmpty()) {
+		return QByteArray();
+	}
+
+	QCryptographicHash hash(QCryptographicHash::Sha256);
+
+	//a new layout format invalidate the cached layouts
+	hash.addData(QByteArray::number(DocumentLayout::BinaryVersion));
+	hash.addData(docTemplate.encapsulateToBinary());
+	hash.addData(dataHash);
+	hash.addData(context);
+
+	//the space reserved for plugin items depends on the plugin implementation
+	QSet<QString> plugins;
+	addPlugins(hash, docTemplate.subitems(), pluginManager, plugins);
+
+	return hash.result();
+}
+
+bool LayoutCache::load(QByteArray const& key, DocumentTemplate const& docTemplate, DocumentLayout & layout) {
+
+	if (key.isEmpty()) {
+		return false;
+	}
+
+	QFile file(filePath(key));
+
+	bool found = file.open(QIODevice::ReadOnly) and layout.configureFromBinary(file.readAll(), docTemplate);
+
+	QMutexLocker locker(&_mutex);
+
+	if (found) {
+		_statistics.hits++;
+	} else {
+		_statistics.misses++;
+	}
+
+	return found;
+}
+
+bool LayoutCache::store(QByteArray const& key, DocumentLayout const& layout) {
+
+	if (key.isEmpty() or !layout.isSerializable()) {
+		return false;
+	}
+
+	//write to a temporary file first, so other processes never read a partial layout.
+	QSaveFile file(filePath(key));
+
+	if (!file.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+
+	file.write(layout.encapsulateToBinary());
+
+	if (!file.commit()) {
+		return false;
+	}
+
+	QMutexLocker locker(&_mutex);
+	_statistics.stores++;
+
+	return true;
+}
+
+void LayoutCache::clear() {
+
+	QDir dir(_directory);
+
+	for (QString const& fileName : dir.entryList(QStringList() << QString("*.%1").arg(FileSuffix), QDir::Files)) {
+		dir.remove(fileName);
+	}
+}
+
+LayoutCache::Statistics LayoutCache::statistics() const {
+	QMutexLocker locker(&_mutex);
+	return _statistics;
+}
+
+QString LayoutCache::filePath(QByteArray const& key) const {
+	return QDir(_directory).filePath(QString("%1.%2").arg(QString::fromLatin1(key.toHex()), FileSuffix));
+}
+
+} // namespace AutoQuill
@@ -0,0 +1,90 @@
+#ifndef LAYOUTCACHE_H
+#define LAYOUTCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+
+namespace AutoQuill {
+
+class DocumentTemplate;
+class DocumentDataInterface;
+class DocumentLayout;
+class RenderPluginManager;
+
+/*!
+ * \brief The LayoutCache class store encoded layouts in a directory, so unchanged documents do not need to be laid out again.
+ *
+ * Layouts are stored under a key made from the template and the hash of the data (see DocumentDataInterface::contentHash).
+ * Data interfaces which cannot be hashed are never cached, nor are layouts which cannot be encoded without loss
+ * (see DocumentLayout::isSerializable). A cache can be shared by several renderers and threads.
+ */
+class LayoutCache
+{
+public:
+
+	struct Statistics {
+		int hits;
+		int misses;
+		int stores;
+	};
+
+	static constexpr char const* FileSuffix = "aqtl";
+
+	/*!
+	 * \brief LayoutCache build a cache
+	 * \param directory the directory the layouts are stored in, it is created if needed.
+	 */
+	explicit LayoutCache(QString const& directory);
+
+	inline QString const& directory() const {
+		return _directory;
+	}
+
+	/*!
+	 * \brief key compute the key of a layout
+	 * \param docTemplate the template
+	 * \param dataInterface the data
+	 * \param context anything else the layout depends on (e.g. the resolution of the device fonts are measured on).
+	 * \param pluginManager the plugins used to lay out the document, their versions are part of the key.
+	 * \return the key, or an empty array if the data cannot be hashed.
+	 */
+	static QByteArray key(DocumentTemplate const& docTemplate,
+						  DocumentDataInterface const& dataInterface,
+						  QByteArray const& context = QByteArray(),
+						  RenderPluginManager const* pluginManager = nullptr);
+
+	/*!
+	 * \brief load load a layout from the cache
+	 * \param key the key of the layout
+	 * \param docTemplate the template the layout was computed for
+	 * \param layout receive the layout
+	 * \return true if the layout was found and could be decoded.
+	 */
+	bool load(QByteArray const& key, DocumentTemplate const& docTemplate, DocumentLayout & layout);
+	/*!
+	 * \brief store store a layout in the cache, replacing the previous layout with the same key.
+	 * \return true on success, false if the layout could not be written or is not serializable.
+	 */
+	bool store(QByteArray const& key, DocumentLayout const& layout);
+
+	/*!
+	 * \brief clear remove all the layouts of the cache.
+	 */
+	void clear();
+
+	Statistics statistics() const;
+
+protected:
+
+	QString filePath(QByteArray const& key) const;
+
+	QString _directory;
+
+	mutable QMutex _mutex;
+	Statistics _statistics;
+};
+
+} // namespace AutoQuill
+
+#endif // LAYOUTCACHE_H
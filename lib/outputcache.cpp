@@ -0,0 +1,236 @@
+#include "outputcache.h"
+
+#include "documenttemplate.h"
+#include "documentitem.h"
+#include "documentrenderer.h"
+#include "renderplugin.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QFont>
+#include <QFontInfo>
+#include <QRawFont>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+namespace AutoQuill {
+
+constexpr char const* OutputCache::FileSuffix;
+
+namespace {
+
+struct AssetsHasher {
+
+	AssetsHasher(RenderPluginManager const& pluginManager) :
+		pluginManager(pluginManager),
+		hash(QCryptographicHash::Sha256)
+	{
+
+	}
+
+	void addNodes(QVector<ItemRenderInfos*> const& nodes) {
+
+		for (ItemRenderInfos const* node : nodes) {
+			if (node == nullptr) {
+				continue;
+			}
+
+			if (node->item != nullptr and node->toRender) {
+				addItem(*node);
+			}
+
+			addNodes(node->subitemsRenderInfos);
+		}
+	}
+
+	void addItem(ItemRenderInfos const& node) {
+
+		switch (node.item->getType()) {
+		case DocumentItem::Image:
+		{
+			//same lookup as the renderer, images given directly as values are part of the data.
+			QVariant value = node.itemValue.getValue();
+
+			if (!value.isValid()) {
+				addImage(node.item->data());
+			} else if (value.type() == QVariant::String) {
+				addImage(value.toString());
+			}
+			break;
+		}
+		case DocumentItem::Text:
+			addFont(node.item->fontName());
+			break;
+		case DocumentItem::Plugin:
+			addPlugin(node.item->data());
+			break;
+		default:
+			break;
+		}
+	}
+
+	void addImage(QString const& path) {
+
+		if (path.isEmpty() or images.contains(path)) {
+			return;
+		}
+		images.insert(path);
+
+		hash.addData(QString("image:%1\n").arg(path).toUtf8());
+
+		QFile file(path);
+
+		if (!file.open(QIODevice::ReadOnly)) {
+			hash.addData("missing\n");
+			return;
+		}
+
+		hash.addData(&file);
+	}
+
+	void addFont(QString const& family) {
+
+		if (fonts.contains(family)) {
+			return;
+		}
+		fonts.insert(family);
+
+		QFont font("serif", 12);
+		font.setFamily(family);
+
+		//the header table contain the font revision and checksum, so it change along with the font file.
+		QRawFont rawFont = QRawFont::fromFont(font);
+
+		hash.addData(QString("font:%1:%2\n").arg(family, QFontInfo(font).family()).toUtf8());
+		hash.addData(rawFont.fontTable("head"));
+	}
+
+	void addPlugin(QString const& name) {
+
+		if (plugins.contains(name)) {
+			return;
+		}
+		plugins.insert(name);
+
+		RenderPlugin const* plugin = pluginManager.getPlugin(name);
+
+		hash.addData(QString("plugin:%1:%2\n").arg(name, (plugin != nullptr) ? plugin->version() : QString("missing")).toUtf8());
+	}
+
+	RenderPluginManager const& pluginManager;
+	QCryptographicHash hash;
+
+	QSet<QString> images;
+	QSet<QString> fonts;
+	QSet<QString> plugins;
+};
+
+} // namespace
+
+OutputCache::OutputCache(QString const& directory) :
+	_directory(directory),
+	_statistics{0, 0, 0}
+{
+	QDir().mkpath(_directory);
+}
+
+QByteArray OutputCache::key(DocumentTemplate const& docTemplate,
+							QByteArray const& dataDigest,
+							DocumentLayout const& layout,
+							RenderPluginManager const& pluginManager) {
+
+	QCryptographicHash hash(QCryptographicHash::Sha256);
+
+	hash.addData(docTemplate.encapsulateToBinary());
+	hash.addData(dataDigest);
+	hash.addData(assetsHash(layout, pluginManager));
+
+	return hash.result();
+}
+
+QByteArray OutputCache::assetsHash(DocumentLayout const& layout, RenderPluginManager const& pluginManager) {
+
+	AssetsHasher hasher(pluginManager);
+	hasher.addNodes(layout.items());
+
+	return hasher.hash.result();
+}
+
+bool OutputCache::fetch(QByteArray const& key, QIODevice* device, qint64* bytesWritten) {
+
+	QFile file(filePath(key));
+
+	bool found = !key.isEmpty() and device != nullptr and file.open(QIODevice::ReadOnly);
+
+	if (found) {
+		QByteArray document = file.readAll();
+
+		if (!device->isOpen()) {
+			device->open(QIODevice::WriteOnly);
+		}
+
+		qint64 written = device->write(document);
+		found = written == document.size();
+
+		if (bytesWritten != nullptr) {
+			*bytesWritten = written;
+		}
+	}
+
+	QMutexLocker locker(&_mutex);
+
+	if (found) {
+		_statistics.hits++;
+	} else {
+		_statistics.misses++;
+	}
+
+	return found;
+}
+
+bool OutputCache::store(QByteArray const& key, QByteArray const& document) {
+
+	if (key.isEmpty()) {
+		return false;
+	}
+
+	//write to a temporary file first, so other processes never read a partial document.
+	QSaveFile file(filePath(key));
+
+	if (!file.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+
+	file.write(document);
+
+	if (!file.commit()) {
+		return false;
+	}
+
+	QMutexLocker locker(&_mutex);
+	_statistics.stores++;
+
+	return true;
+}
+
+void OutputCache::clear() {
+
+	QDir dir(_directory);
+
+	for (QString const& fileName : dir.entryList(QStringList() << QString("*.%1").arg(FileSuffix), QDir::Files)) {
+		dir.remove(fileName);
+	}
+}
+
+OutputCache::Statistics OutputCache::statistics() const {
+	QMutexLocker locker(&_mutex);
+	return _statistics;
+}
+
+QString OutputCache::filePath(QByteArray const& key) const {
+	return QDir(_directory).filePath(QString("%1.%2").arg(QString::fromLatin1(key.toHex()), FileSuffix));
+}
+
+} // namespace AutoQuill
@@ -0,0 +1,98 @@
+#ifndef OUTPUTCACHE_H
+#define OUTPUTCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+
+class QIODevice;
+
+namespace AutoQuill {
+
+class DocumentTemplate;
+class DocumentLayout;
+class RenderPluginManager;
+
+/*!
+ * \brief The OutputCache class store rendered documents in a directory, so unchanged documents do not need to be rendered again.
+ *
+ * Documents are stored under a content hash covering the template, the data values read by the layout
+ * (see RecordingDataInterface), and the assets the document use: image files, fonts and plugins versions.
+ * A cache can be shared by several renderers and threads.
+ */
+class OutputCache
+{
+public:
+
+	struct Statistics {
+		int hits;
+		int misses;
+		int stores;
+	};
+
+	static constexpr char const* FileSuffix = "pdf";
+
+	/*!
+	 * \brief OutputCache build a cache
+	 * \param directory the directory the documents are stored in, it is created if needed.
+	 */
+	explicit OutputCache(QString const& directory);
+
+	inline QString const& directory() const {
+		return _directory;
+	}
+
+	/*!
+	 * \brief key compute the content hash of a document
+	 * \param docTemplate the template
+	 * \param dataDigest the hash of the data values read during the layout
+	 * \param layout the layout of the document, used to find the assets it use
+	 * \param pluginManager the plugins used to render the document
+	 * \return the key.
+	 */
+	static QByteArray key(DocumentTemplate const& docTemplate,
+						  QByteArray const& dataDigest,
+						  DocumentLayout const& layout,
+						  RenderPluginManager const& pluginManager);
+
+	/*!
+	 * \brief assetsHash hash the contents of the image files, the fonts and the plugins versions used by a layout.
+	 *
+	 * Fonts are identified by the family they resolve to and their header table, which change with the font file version.
+	 */
+	static QByteArray assetsHash(DocumentLayout const& layout, RenderPluginManager const& pluginManager);
+
+	/*!
+	 * \brief fetch write a cached document to a device
+	 * \param key the content hash of the document
+	 * \param device the device to write to, opened if needed.
+	 * \param bytesWritten if not null, receive the size of the document.
+	 * \return true if the document was in the cache and has been written.
+	 */
+	bool fetch(QByteArray const& key, QIODevice* device, qint64* bytesWritten = nullptr);
+	/*!
+	 * \brief store store a document in the cache, replacing the previous document with the same key.
+	 * \return true on success.
+	 */
+	bool store(QByteArray const& key, QByteArray const& document);
+
+	/*!
+	 * \brief clear remove all the documents of the cache.
+	 */
+	void clear();
+
+	Statistics statistics() const;
+
+protected:
+
+	QString filePath(QByteArray const& key) const;
+
+	QString _directory;
+
+	mutable QMutex _mutex;
+	Statistics _statistics;
+};
+
+} // namespace AutoQuill
+
+#endif // OUTPUTCACHE_H
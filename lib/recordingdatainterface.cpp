@@ -0,0 +1,121 @@
+#include "recordingdatainterface.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace AutoQuill {
+
+struct RecordingDataInterface::Recorder {
+
+	Recorder() :
+		hash(QCryptographicHash::Sha256),
+		nReads(0)
+	{
+
+	}
+
+	void record(QString const& path, quint8 kind, QVariant const& value) {
+
+		QByteArray entry;
+		QDataStream out(&entry, QIODevice::WriteOnly);
+		out.setVersion(QDataStream::Qt_5_0);
+		out << path << kind << value;
+
+		QMutexLocker locker(&mutex);
+		hash.addData(entry);
+		nReads++;
+	}
+
+	QMutex mutex;
+	QCryptographicHash hash;
+	int nReads;
+};
+
+namespace {
+
+enum RecordedKind : quint8 {
+	Missing = 0,
+	Array = 1,
+	Map = 2,
+	Data = 3
+};
+
+} // namespace
+
+DocumentValue RecordingDataInterface::recordValue(QSharedPointer<Recorder> const& recorder,
+												  DocumentValue const& value,
+												  QString const& path) {
+
+	if (value.hasArray()) {
+		recorder->record(path, Array, value.arraySize());
+
+		return DocumentValue([recorder, value, path] (int idx) -> DocumentValue {
+			return recordValue(recorder, value.getValue(idx), path + "/" + QString::number(idx));
+		}, value.arraySize());
+	}
+
+	if (value.hasMap()) {
+		recorder->record(path, Map, QVariant());
+
+		return DocumentValue([recorder, value, path] (QString const& key) -> DocumentValue {
+			return recordValue(recorder, value.getValue(key), path + "/" + key);
+		});
+	}
+
+	if (value.hasData()) {
+		//the value is recorded when it is read, as only the path might be needed.
+		return DocumentValue([recorder, value, path] () -> QVariant {
+			QVariant data = value.getValue();
+			recorder->record(path, Data, data);
+			return data;
+		});
+	}
+
+	recorder->record(path, Missing, QVariant());
+	return DocumentValue();
+}
+
+RecordingDataInterface::RecordingDataInterface(DocumentDataInterface const* source, QObject* parent) :
+	DocumentDataInterface(parent),
+	_source(source),
+	_recorder(new Recorder())
+{
+
+}
+
+DocumentValue RecordingDataInterface::getValue(QString const& key) const {
+
+	if (_source == nullptr) {
+		return DocumentValue();
+	}
+
+	return recordValue(_recorder, _source->getValue(key), key);
+}
+
+QByteArray RecordingDataInterface::contentHash() const {
+
+	if (_source == nullptr) {
+		return QByteArray();
+	}
+
+	return _source->contentHash();
+}
+
+QByteArray RecordingDataInterface::digest() const {
+	QMutexLocker locker(&_recorder->mutex);
+	return _recorder->hash.result();
+}
+
+int RecordingDataInterface::nReads() const {
+	QMutexLocker locker(&_recorder->mutex);
+	return _recorder->nReads;
+}
+
+void RecordingDataInterface::reset() {
+	//values already returned keep recording into the previous state.
+	_recorder = QSharedPointer<Recorder>(new Recorder());
+}
+
+} // namespace AutoQuill
@@ -0,0 +1,61 @@
+#ifndef RECORDINGDATAINTERFACE_H
+#define RECORDINGDATAINTERFACE_H
+
+#include "./documentdatainterface.h"
+
+#include <QByteArray>
+#include <QSharedPointer>
+
+namespace AutoQuill {
+
+/*!
+ * \brief The RecordingDataInterface class forward the reads to another data interface, and hash the values which are read.
+ *
+ * The layout reads the data in a deterministic order, so two layouts of the same template which read the same values
+ * give the same digest, whatever the rest of the data contains. The digest cover the paths of the values, the absent
+ * values, the size of the arrays and the scalar values.
+ *
+ * The values returned keep the recorder state alive, so they can outlive the interface.
+ */
+class RecordingDataInterface : public DocumentDataInterface
+{
+public:
+	/*!
+	 * \brief RecordingDataInterface build a recording interface
+	 * \param source the interface to read from, it has to outlive the recording interface and the values it returns.
+	 */
+	explicit RecordingDataInterface(DocumentDataInterface const* source, QObject* parent = nullptr);
+
+	virtual DocumentValue getValue(QString const& key) const override;
+	virtual QByteArray contentHash() const override;
+
+	/*!
+	 * \brief digest give the hash of the values read so far.
+	 */
+	QByteArray digest() const;
+	/*!
+	 * \brief nReads give the number of values read so far.
+	 */
+	int nReads() const;
+
+	/*!
+	 * \brief reset forget the values read so far.
+	 */
+	void reset();
+
+protected:
+
+	struct Recorder;
+
+	/*!
+	 * \brief recordValue wrap a value so that the values read from it are recorded.
+	 */
+	static DocumentValue recordValue(QSharedPointer<Recorder> const& recorder, DocumentValue const& value, QString const& path);
+
+	DocumentDataInterface const* _source;
+	QSharedPointer<Recorder> _recorder;
+};
+
+} // namespace AutoQuill
+
+#endif // RECORDINGDATAINTERFACE_H
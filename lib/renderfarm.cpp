@@ -0,0 +1,375 @@
+#include "renderfarm.h"
+
+#include "documenttemplate.h"
+#include "jsondocumentdatainterface.h"
+#include "renderplugin.h"
+
+#include <QProcess>
+#include <QEventLoop>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QFile>
+#include <QFileDevice>
+#include <QJsonDocument>
+#include <QThread>
+
+#include <algorithm>
+
+namespace AutoQuill {
+
+/*!
+ * \brief The RenderFarm::Scheduler class hand the jobs of a run to the workers, and collect their results.
+ */
+class RenderFarm::Scheduler
+{
+public:
+
+	struct Worker {
+		QProcess* process;
+		int job; //job in progress, -1 if none
+	};
+
+	Scheduler(RenderFarm & farm, QVector<Job> const& jobs) :
+		_farm(farm),
+		_jobs(jobs),
+		_results(jobs.size(), Result{false, -1, QString(), 0, QJsonObject()}),
+		_remaining(jobs.size())
+	{
+		for (int i = 0; i < jobs.size(); i++) {
+			_queue.enqueue(i);
+		}
+	}
+
+	~Scheduler() {
+		for (Worker* worker : qAsConst(_workers)) {
+			worker->process->disconnect();
+			worker->process->closeWriteChannel();
+
+			if (!worker->process->waitForFinished(30000)) {
+				worker->process->kill();
+				worker->process->waitForFinished();
+			}
+
+			delete worker->process;
+			delete worker;
+		}
+	}
+
+	QVector<Result> run() {
+
+		int nWorkers = std::min(_farm._nWorkers, _jobs.size());
+
+		for (int i = 0; i < nWorkers; i++) {
+			startWorker();
+		}
+
+		if (_remaining > 0) {
+			_loop.exec();
+		}
+
+		//the processes of the workers which exited are deleted later.
+		QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+		return _results;
+	}
+
+protected:
+
+	void startWorker() {
+
+		Worker* worker = new Worker{new QProcess(), -1};
+		QProcess* process = worker->process;
+
+		process->setProgram(_farm._workerProgram);
+		process->setArguments(_farm._workerArguments);
+		process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+		QObject::connect(process, &QProcess::readyReadStandardOutput, [this, worker] () {
+			readResults(worker);
+		});
+		QObject::connect(process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+						 [this, worker] (int exitCode, QProcess::ExitStatus exitStatus) {
+			Q_UNUSED(exitCode);
+			Q_UNUSED(exitStatus);
+			workerExited(worker);
+		});
+		QObject::connect(process, &QProcess::errorOccurred, [this, worker] (QProcess::ProcessError error) {
+			if (error == QProcess::FailedToStart) {
+				workerFailedToStart(worker);
+			}
+		});
+
+		_workers.push_back(worker);
+		_farm._statistics.workersStarted++;
+
+		process->start();
+
+		if (_workers.contains(worker)) { //the start might fail immediately
+			assignJob(worker);
+		}
+	}
+
+	void assignJob(Worker* worker) {
+
+		if (_queue.isEmpty()) {
+			worker->job = -1;
+			worker->process->closeWriteChannel(); //the worker exit once its input is closed
+			return;
+		}
+
+		int id = _queue.dequeue();
+		Job const& job = _jobs[id];
+
+		worker->job = id;
+		_results[id].attempts++;
+
+		QJsonObject message;
+		message.insert("id", id);
+		message.insert("template", job.templatePath);
+		message.insert("data", job.dataPath);
+		message.insert("output", job.outputPath);
+
+		worker->process->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + "\n");
+	}
+
+	void readResults(Worker* worker) {
+
+		while (worker->process->canReadLine()) {
+
+			QJsonObject message = QJsonDocument::fromJson(worker->process->readLine()).object();
+			int id = message.value("id").toInt(-1);
+
+			if (id < 0 or id != worker->job) {
+				continue; //not an answer to the current job
+			}
+
+			Result & result = _results[id];
+			result.status = message.value("status").toInt(-1);
+			result.success = result.status == DocumentRenderer::Success;
+			result.message = message.value("message").toString();
+			result.statistics = message.value("statistics").toObject();
+
+			finishJob(id);
+			assignJob(worker);
+		}
+	}
+
+	void workerExited(Worker* worker) {
+
+		readResults(worker); //the last answer might still be buffered
+
+		int id = worker->job;
+		bool crashed = id >= 0;
+
+		removeWorker(worker);
+
+		if (!crashed) {
+			return;
+		}
+
+		_farm._statistics.workersCrashed++;
+
+		if (_results[id].attempts >= _farm._maxAttempts) {
+			_results[id].message = QObject::tr("Worker crashed while rendering %1 (%2 attempts)").arg(_jobs[id].outputPath).arg(_results[id].attempts);
+			finishJob(id);
+		} else {
+			_queue.prepend(id); //retry the job first
+		}
+
+		if (!_queue.isEmpty()) {
+			startWorker();
+		}
+	}
+
+	void workerFailedToStart(Worker* worker) {
+
+		QString error = worker->process->errorString();
+
+		int id = worker->job;
+		removeWorker(worker);
+
+		if (id >= 0) {
+			_results[id].message = QObject::tr("Could not start worker: %1").arg(error);
+			finishJob(id);
+		}
+
+		if (!_workers.isEmpty()) {
+			return; //the other workers take the remaining jobs
+		}
+
+		while (!_queue.isEmpty()) {
+			int queued = _queue.dequeue();
+			_results[queued].message = QObject::tr("Could not start worker: %1").arg(error);
+			finishJob(queued);
+		}
+	}
+
+	void removeWorker(Worker* worker) {
+		_workers.removeOne(worker);
+		worker->process->disconnect();
+		worker->process->deleteLater();
+		delete worker;
+	}
+
+	void finishJob(int id) {
+
+		if (_results[id].success) {
+			_farm._statistics.jobsSucceeded++;
+		} else {
+			_farm._statistics.jobsFailed++;
+		}
+
+		_remaining--;
+
+		if (_remaining <= 0) {
+			_loop.quit();
+		}
+	}
+
+	RenderFarm & _farm;
+	QVector<Job> _jobs;
+	QVector<Result> _results;
+	QQueue<int> _queue;
+	QList<Worker*> _workers;
+	int _remaining;
+
+	QEventLoop _loop;
+};
+
+RenderFarm::RenderFarm(QString const& workerProgram, QStringList const& workerArguments) :
+	_workerProgram(workerProgram),
+	_workerArguments(workerArguments),
+	_nWorkers(std::max(1, QThread::idealThreadCount())),
+	_maxAttempts(2),
+	_statistics{0, 0, 0, 0, 0}
+{
+
+}
+
+void RenderFarm::setNWorkers(int nWorkers) {
+	_nWorkers = std::max(1, nWorkers);
+}
+
+void RenderFarm::setMaxAttempts(int maxAttempts) {
+	_maxAttempts = std::max(1, maxAttempts);
+}
+
+QVector<RenderFarm::Result> RenderFarm::run(QVector<Job> const& jobs) {
+
+	_statistics = Statistics{0, 0, 0, 0, 0};
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QVector<Result> results;
+
+	{
+		Scheduler scheduler(*this, jobs);
+		results = scheduler.run();
+	}
+
+	_statistics.wallNs = timer.nsecsElapsed();
+
+	return results;
+}
+
+RenderFarm::Result RenderFarm::renderJob(Job const& job, RenderPluginManager const& pluginManager) {
+
+	DocumentTemplate docTemplate;
+
+	if (!docTemplate.loadFrom(job.templatePath)) {
+		return Result{false, -1, QObject::tr("Could not load template %1").arg(job.templatePath), 1, QJsonObject()};
+	}
+
+	QFile dataFile(job.dataPath);
+
+	if (!dataFile.open(QIODevice::ReadOnly)) {
+		return Result{false, -1, QObject::tr("Could not open data file %1").arg(job.dataPath), 1, QJsonObject()};
+	}
+
+	QJsonParseError parseError;
+	QJsonDocument data = QJsonDocument::fromJson(dataFile.readAll(), &parseError);
+
+	if (parseError.error != QJsonParseError::NoError or !data.isObject()) {
+		return Result{false, -1, QObject::tr("Invalid json data file %1: %2").arg(job.dataPath, parseError.errorString()), 1, QJsonObject()};
+	}
+
+	JsonDocumentDataInterface dataInterface(data.object());
+	DocumentRenderer renderer(docTemplate);
+
+	DocumentRenderer::RenderingStatus status = renderer.render(&dataInterface, pluginManager, job.outputPath);
+
+	QJsonObject statistics;
+
+	if (!status.statistics.isNull()) {
+		statistics = statisticsToJson(*status.statistics);
+	}
+
+	return Result{status.status == DocumentRenderer::Success, status.status, status.message, 1, statistics};
+}
+
+int RenderFarm::runWorker(QIODevice & input, QIODevice & output, RenderPluginManager const& pluginManager) {
+
+	while (true) {
+
+		QByteArray line = input.readLine();
+
+		if (line.isEmpty()) {
+			break; //the input has been closed
+		}
+
+		QJsonObject message = QJsonDocument::fromJson(line).object();
+
+		if (!message.contains("id")) {
+			continue;
+		}
+
+		Job job{message.value("template").toString(),
+				message.value("data").toString(),
+				message.value("output").toString()};
+
+		Result result = renderJob(job, pluginManager);
+
+		QJsonObject answer;
+		answer.insert("id", message.value("id"));
+		answer.insert("status", result.status);
+		answer.insert("message", result.message);
+		answer.insert("statistics", result.statistics);
+
+		output.write(QJsonDocument(answer).toJson(QJsonDocument::Compact) + "\n");
+
+		QFileDevice* outputFile = qobject_cast<QFileDevice*>(&output);
+
+		if (outputFile != nullptr) {
+			outputFile->flush();
+		}
+	}
+
+	return 0;
+}
+
+QJsonObject RenderFarm::statisticsToJson(DocumentRenderer::RenderStatistics const& statistics) {
+
+	QJsonObject obj;
+
+	obj.insert("nodes_allocated", statistics.nodesAllocated);
+	obj.insert("paragraphs_shaped", statistics.paragraphsShaped);
+	obj.insert("lines_broken", statistics.linesBroken);
+	obj.insert("images_decoded", statistics.imagesDecoded);
+	obj.insert("image_bytes_read", statistics.imageBytesRead);
+	obj.insert("plugin_calls", statistics.pluginCalls);
+	obj.insert("pages_produced", statistics.pagesProduced);
+	obj.insert("bytes_written", statistics.bytesWritten);
+	obj.insert("peak_memory_bytes", statistics.peakMemoryBytes);
+	obj.insert("layout_cache_hits", statistics.layoutCacheHits);
+	obj.insert("output_cache_hits", statistics.outputCacheHits);
+	obj.insert("layout_wall_ns", statistics.layoutWallNs);
+	obj.insert("layout_cpu_ns", statistics.layoutCpuNs);
+	obj.insert("render_wall_ns", statistics.renderWallNs);
+	obj.insert("render_cpu_ns", statistics.renderCpuNs);
+
+	return obj;
+}
+
+} // namespace AutoQuill
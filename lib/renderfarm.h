@@ -0,0 +1,121 @@
+#ifndef RENDERFARM_H
+#define RENDERFARM_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QJsonObject>
+
+#include "./documentrenderer.h"
+
+class QIODevice;
+
+namespace AutoQuill {
+
+class RenderPluginManager;
+
+/*!
+ * \brief The RenderFarm class render a list of documents on a pool of local worker processes.
+ *
+ * Qt painting and font handling have process wide state, which limit how well rendering scale with threads.
+ * The farm start workers processes (a program calling runWorker, e.g. AutoQuillRenderFarm --worker) and talk to them
+ * through their standard input and output, one json object per line:
+ * - the farm send {"id", "template", "data", "output"} to render a document,
+ * - the worker answer {"id", "status", "message", "statistics"} once the document is written.
+ *
+ * Each worker get a single job at a time and a new one as soon as it is done, so faster workers take more jobs.
+ * Workers which crash are restarted and their job is retried, up to a number of attempts.
+ */
+class RenderFarm
+{
+public:
+
+	struct Job {
+		QString templatePath;
+		QString dataPath; //json data file
+		QString outputPath; //pdf file
+	};
+
+	struct Result {
+		bool success;
+		int status; //the DocumentRenderer::Status, or -1 if the job could not be run
+		QString message;
+		int attempts; //number of workers the job has been given to
+		QJsonObject statistics; //the RenderStatistics of the job, see statisticsToJson
+	};
+
+	struct Statistics {
+		int workersStarted;
+		int workersCrashed;
+		int jobsSucceeded;
+		int jobsFailed;
+		qint64 wallNs;
+	};
+
+	/*!
+	 * \brief RenderFarm build a farm
+	 * \param workerProgram the program run by the workers
+	 * \param workerArguments the arguments of the program.
+	 */
+	explicit RenderFarm(QString const& workerProgram, QStringList const& workerArguments = QStringList{"--worker"});
+
+	/*!
+	 * \brief setNWorkers set the number of worker processes (by default, the number of cores).
+	 */
+	void setNWorkers(int nWorkers);
+	inline int nWorkers() const {
+		return _nWorkers;
+	}
+
+	/*!
+	 * \brief setMaxAttempts set the number of times a job is given to a worker before being considered failed (2 by default).
+	 *
+	 * Only crashes are retried, jobs which fail to render are not.
+	 */
+	void setMaxAttempts(int maxAttempts);
+	inline int maxAttempts() const {
+		return _maxAttempts;
+	}
+
+	/*!
+	 * \brief run render a list of jobs, and wait for them to be done
+	 * \param jobs the jobs
+	 * \return the results, in the same order as the jobs.
+	 */
+	QVector<Result> run(QVector<Job> const& jobs);
+
+	/*!
+	 * \brief statistics give the statistics of the last run.
+	 */
+	inline Statistics const& statistics() const {
+		return _statistics;
+	}
+
+	/*!
+	 * \brief renderJob render a single job in the current process.
+	 */
+	static Result renderJob(Job const& job, RenderPluginManager const& pluginManager);
+
+	/*!
+	 * \brief runWorker read jobs from input, render them and write the results to output, until input is closed.
+	 * \return 0, the exit code of the worker.
+	 */
+	static int runWorker(QIODevice & input, QIODevice & output, RenderPluginManager const& pluginManager);
+
+	static QJsonObject statisticsToJson(DocumentRenderer::RenderStatistics const& statistics);
+
+protected:
+
+	class Scheduler;
+
+	QString _workerProgram;
+	QStringList _workerArguments;
+	int _nWorkers;
+	int _maxAttempts;
+
+	Statistics _statistics;
+};
+
+} // namespace AutoQuill
+
+#endif // RENDERFARM_H
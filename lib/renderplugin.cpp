@@ -14,7 +14,46 @@ RenderPlugin::~RenderPlugin()
 
 }
 
-RenderPluginManager::RenderPluginManager() {
+bool RenderPlugin::isThreadSafe() const {
+	return false;
+}
+
+QString RenderPlugin::version() const {
+	return QString();
+}
+
+PluginPreparedData::~PluginPreparedData()
+{
+
+}
+
+int PluginPreparedData::cost() const {
+	return 1;
+}
+
+PreparedRenderPlugin::PreparedRenderPlugin()
+{
+
+}
+
+QByteArray PreparedRenderPlugin::valueHash(DocumentValue const& val) const {
+	Q_UNUSED(val);
+	return QByteArray();
+}
+
+QRectF PreparedRenderPlugin::getMinimalSpace(QRectF const& availableSpace, DocumentValue const& val) const {
+	QSharedPointer<const PluginPreparedData> prepared = prepare(val);
+	return getPreparedMinimalSpace(availableSpace, prepared.data());
+}
+
+DocumentRenderer::RenderingStatus PreparedRenderPlugin::renderItem(QRectF const& area, QPainter & painter, DocumentValue const& val) const {
+	QSharedPointer<const PluginPreparedData> prepared = prepare(val);
+	return renderPreparedItem(area, painter, prepared.data());
+}
+
+RenderPluginManager::RenderPluginManager() :
+	_preparedCache(256)
+{
 
 }
 RenderPluginManager::~RenderPluginManager() {
@@ -48,4 +87,59 @@ bool RenderPluginManager::registerPlugin(QString const& key, RenderPlugin* plugi
 	return true;
 }
 
+QMutex* RenderPluginManager::callMutex(RenderPlugin const* plugin) const {
+
+	if (plugin != nullptr and plugin->isThreadSafe()) {
+		return nullptr;
+	}
+
+	return &_callMutex;
+}
+
+QSharedPointer<const PluginPreparedData> RenderPluginManager::preparedData(QString const& key, PreparedRenderPlugin const* plugin, DocumentValue const& val) const {
+
+	if (plugin == nullptr) {
+		return QSharedPointer<const PluginPreparedData>();
+	}
+
+	QByteArray hash = plugin->valueHash(val);
+
+	if (hash.isEmpty()) {
+		return plugin->prepare(val);
+	}
+
+	QByteArray cacheKey = key.toUtf8() + '\0' + hash;
+
+	QMutexLocker locker(&_preparedCacheMutex);
+
+	QSharedPointer<const PluginPreparedData>* cached = _preparedCache.object(cacheKey);
+
+	if (cached != nullptr) {
+		return *cached;
+	}
+
+	locker.unlock(); //do not block the other items while preparing
+
+	QSharedPointer<const PluginPreparedData> prepared = plugin->prepare(val);
+
+	if (prepared.isNull()) {
+		return prepared;
+	}
+
+	locker.relock();
+	_preparedCache.insert(cacheKey, new QSharedPointer<const PluginPreparedData>(prepared), prepared->cost());
+
+	return prepared;
+}
+
+void RenderPluginManager::setPreparedDataCacheSize(int maxCost) {
+	QMutexLocker locker(&_preparedCacheMutex);
+	_preparedCache.setMaxCost(maxCost);
+}
+
+void RenderPluginManager::clearPreparedDataCache() {
+	QMutexLocker locker(&_preparedCacheMutex);
+	_preparedCache.clear();
+}
+
 } // namespace AutoQuill
@@ -5,6 +5,10 @@
 #include "./documentdatainterface.h"
 
 #include <QMap>
+#include <QMutex>
+#include <QCache>
+#include <QSharedPointer>
+#include <QByteArray>
 
 namespace AutoQuill {
 
@@ -17,6 +21,68 @@ public:
 	virtual QRectF getMinimalSpace(QRectF const& availableSpace, DocumentValue const& val) const = 0;
 
 	virtual DocumentRenderer::RenderingStatus renderItem(QRectF const& area, QPainter & painter, DocumentValue const& val) const = 0;
+
+	/*!
+	 * \brief isThreadSafe indicate if the plugin can be called from several threads at the same time.
+	 * \return true if getMinimalSpace and renderItem are reentrant, false (the default) otherwise.
+	 *
+	 * Thread safe plugins are drawn on worker threads, into a QPicture which is then replayed on the document,
+	 * and can be measured concurrently by renderers running in different threads. The DocumentValue they receive
+	 * is then read from a worker thread as well. The painter they receive has the render hints and the resolution
+	 * of the document painter, but not its clip, which is applied when the picture is replayed.
+	 *
+	 * Calls to plugins which are not thread safe are serialized by the RenderPluginManager.
+	 */
+	virtual bool isThreadSafe() const;
+
+	/*!
+	 * \brief version give the version of the plugin, used to invalidate the cached documents when the plugin output change.
+	 * \return the version (an empty string by default).
+	 */
+	virtual QString version() const;
+};
+
+/*!
+ * \brief The PluginPreparedData class is the base class for the state a PreparedRenderPlugin compute from a value.
+ */
+class PluginPreparedData
+{
+public:
+	virtual ~PluginPreparedData();
+
+	/*!
+	 * \brief cost give the cost of keeping the data in the RenderPluginManager cache (1 by default).
+	 */
+	virtual int cost() const;
+};
+
+/*!
+ * \brief The PreparedRenderPlugin class is a RenderPlugin which does its expensive work (e.g. encoding a QR code, running a chart engine) only once per value.
+ *
+ * The layout calls prepare, then measure the prepared data. The prepared data is kept on the ItemRenderInfos and handed back to the render pass.
+ * If valueHash returns a non empty hash, the prepared data is also cached by the RenderPluginManager, across items and documents.
+ */
+class PreparedRenderPlugin : public RenderPlugin
+{
+public:
+	PreparedRenderPlugin();
+
+	virtual QSharedPointer<const PluginPreparedData> prepare(DocumentValue const& val) const = 0;
+
+	virtual QRectF getPreparedMinimalSpace(QRectF const& availableSpace, PluginPreparedData const* prepared) const = 0;
+
+	virtual DocumentRenderer::RenderingStatus renderPreparedItem(QRectF const& area, QPainter & painter, PluginPreparedData const* prepared) const = 0;
+
+	/*!
+	 * \brief valueHash give a hash identifying the prepared data for a value.
+	 * \return the hash, or an empty byte array (the default) if the prepared data should not be cached.
+	 *
+	 * Two values with the same hash must lead to equivalent prepared data.
+	 */
+	virtual QByteArray valueHash(DocumentValue const& val) const;
+
+	QRectF getMinimalSpace(QRectF const& availableSpace, DocumentValue const& val) const override;
+	DocumentRenderer::RenderingStatus renderItem(QRectF const& area, QPainter & painter, DocumentValue const& val) const override;
 };
 
 /*!
@@ -32,9 +98,34 @@ public:
 
 	bool registerPlugin(const QString &key, RenderPlugin* plugin);
 
+	/*!
+	 * \brief callMutex give the mutex to lock while calling a plugin
+	 * \param plugin the plugin which is going to be called
+	 * \return the mutex shared by all plugins which are not thread safe, or nullptr if the plugin is thread safe.
+	 */
+	QMutex* callMutex(RenderPlugin const* plugin) const;
+
+	/*!
+	 * \brief preparedData get the prepared data of a value, from the cache if possible.
+	 * \param key the key the plugin is registered with.
+	 * \param plugin the plugin
+	 * \param val the value to prepare
+	 * \return the prepared data.
+	 *
+	 * The cache is thread safe, but the caller is responsible for locking the callMutex of the plugin.
+	 */
+	QSharedPointer<const PluginPreparedData> preparedData(QString const& key, PreparedRenderPlugin const* plugin, DocumentValue const& val) const;
+
+	void setPreparedDataCacheSize(int maxCost);
+	void clearPreparedDataCache();
+
 protected:
 
 	QMap<QString, RenderPlugin*> _map;
+	mutable QMutex _callMutex;
+
+	mutable QMutex _preparedCacheMutex;
+	mutable QCache<QByteArray, QSharedPointer<const PluginPreparedData>> _preparedCache;
 };
 
 } // namespace AutoQuill
@@ -0,0 +1,134 @@
+#include "rendertracer.h"
+
+#include "documentitem.h"
+
+#include <QThread>
+#include <QFile>
+#include <QMutexLocker>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QStringList>
+
+namespace AutoQuill {
+
+RenderTracer::RenderTracer()
+{
+	_clock.start();
+}
+
+void RenderTracer::record(const char* phase, DocumentItem const* item, int page, qint64 beginNs, qint64 endNs) {
+
+	Event event;
+	event.phase = phase;
+	event.page = page;
+	event.beginNs = beginNs;
+	event.durationNs = endNs - beginNs;
+
+	if (item != nullptr) {
+		event.name = item->objectName();
+		event.type = DocumentItem::typeToString(item->getType());
+
+		QStringList path;
+
+		for (DocumentItem const* it = item; it != nullptr; it = qobject_cast<DocumentItem const*>(it->parent())) {
+			path.prepend(it->objectName());
+		}
+
+		event.path = path.join('/');
+	}
+
+	quintptr threadKey = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+	QMutexLocker locker(&_mutex);
+
+	if (item != nullptr) {
+		if (!_refs.contains(item)) {
+			//building a reference only set the lazily assigned ref of the items, not their content.
+			_refs.insert(item, const_cast<DocumentItem*>(item)->buildRef());
+		}
+
+		event.ref = _refs.value(item);
+	}
+
+	if (!_threadIds.contains(threadKey)) {
+		_threadIds.insert(threadKey, _threadIds.size()+1);
+	}
+
+	event.thread = _threadIds.value(threadKey);
+
+	_events.push_back(event);
+}
+
+QVector<RenderTracer::Event> RenderTracer::events() const {
+	QMutexLocker locker(&_mutex);
+	return _events;
+}
+
+void RenderTracer::clear() {
+	QMutexLocker locker(&_mutex);
+	_events.clear();
+	_threadIds.clear();
+	_refs.clear();
+	_clock.restart();
+}
+
+QByteArray RenderTracer::toChromeTrace() const {
+
+	QMutexLocker locker(&_mutex);
+
+	QJsonArray traceEvents;
+
+	for (int thread = 1; thread <= _threadIds.size(); thread++) {
+		QJsonObject meta;
+		meta.insert("name", "thread_name");
+		meta.insert("ph", "M");
+		meta.insert("pid", 1);
+		meta.insert("tid", thread);
+		meta.insert("args", QJsonObject{{"name", QString("thread %1").arg(thread)}});
+		traceEvents.push_back(meta);
+	}
+
+	for (Event const& event : _events) {
+
+		QJsonObject args;
+		args.insert("ref", event.ref);
+		args.insert("path", event.path);
+		args.insert("type", event.type);
+		args.insert("page", event.page);
+
+		QJsonObject obj;
+		obj.insert("name", event.name.isEmpty() ? event.type : event.name);
+		obj.insert("cat", event.phase);
+		obj.insert("ph", "X");
+		obj.insert("ts", event.beginNs/1000.);
+		obj.insert("dur", event.durationNs/1000.);
+		obj.insert("pid", 1);
+		obj.insert("tid", event.thread);
+		obj.insert("args", args);
+
+		traceEvents.push_back(obj);
+	}
+
+	QJsonObject trace;
+	trace.insert("traceEvents", traceEvents);
+	trace.insert("displayTimeUnit", "ms");
+
+	return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+bool RenderTracer::saveTo(QString const& path) const {
+
+	QFile out(path);
+
+	if (!out.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+
+	qint64 w_stat = out.write(toChromeTrace());
+	out.close();
+
+	return w_stat >= 0;
+}
+
+} // namespace AutoQuill
@@ -0,0 +1,106 @@
+#ifndef RENDERTRACER_H
+#define RENDERTRACER_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QByteArray>
+
+namespace AutoQuill {
+
+class DocumentItem;
+
+/*!
+ * \brief The RenderTracer class record the time spent laying out and rendering each item of a document.
+ *
+ * The events can be exported in the chrome trace json format, which can be opened in perfetto or chrome://tracing.
+ * A tracer can be shared by several renderers and threads. Renderers without tracer do not record anything.
+ */
+class RenderTracer
+{
+public:
+
+	struct Event {
+		const char* phase; //"layout" or "render"
+		QString name;
+		QString type;
+		QString path; //path of the item in the template, made of the items names
+		QString ref; //reference of the item, unique in the template, see DocumentItem::buildRef
+		int page;
+		int thread;
+		qint64 beginNs;
+		qint64 durationNs;
+	};
+
+	/*!
+	 * \brief The Scope class record an event from its construction to its destruction.
+	 *
+	 * If the tracer is nullptr, the scope does nothing.
+	 */
+	class Scope {
+	public:
+		inline Scope(RenderTracer* tracer, const char* phase, DocumentItem const* item, int page) :
+			_tracer(tracer),
+			_phase(phase),
+			_item(item),
+			_page(page),
+			_beginNs(0)
+		{
+			if (_tracer != nullptr) {
+				_beginNs = _tracer->timestamp();
+			}
+		}
+
+		inline ~Scope() {
+			if (_tracer != nullptr) {
+				_tracer->record(_phase, _item, _page, _beginNs, _tracer->timestamp());
+			}
+		}
+
+	private:
+		Scope(Scope const&) = delete;
+		Scope& operator=(Scope const&) = delete;
+
+		RenderTracer* _tracer;
+		const char* _phase;
+		DocumentItem const* _item;
+		int _page;
+		qint64 _beginNs;
+	};
+
+	RenderTracer();
+
+	/*!
+	 * \brief timestamp give the time since the tracer was created or cleared.
+	 */
+	inline qint64 timestamp() const {
+		return _clock.nsecsElapsed();
+	}
+
+	void record(const char* phase, DocumentItem const* item, int page, qint64 beginNs, qint64 endNs);
+
+	QVector<Event> events() const;
+	void clear();
+
+	/*!
+	 * \brief toChromeTrace export the events in the chrome trace event format.
+	 * \return the trace, as json.
+	 */
+	QByteArray toChromeTrace() const;
+	bool saveTo(QString const& path) const;
+
+protected:
+
+	QElapsedTimer _clock;
+
+	mutable QMutex _mutex;
+	QVector<Event> _events;
+	QHash<quintptr, int> _threadIds;
+	QHash<DocumentItem const*, QString> _refs; //buildRef modifies the items, so it is only called with the mutex held.
+};
+
+} // namespace AutoQuill
+
+#endif // RENDERTRACER_H
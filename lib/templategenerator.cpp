@@ -0,0 +1,264 @@
+#include "templategenerator.h"
+
+#include "documenttemplate.h"
+#include "documentitem.h"
+
+#include <QJsonArray>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace AutoQuill {
+
+namespace {
+
+constexpr qreal pageWidth = 595;
+constexpr qreal pageHeight = 842;
+
+constexpr qreal textHeight = 10;
+constexpr qreal textFontSize = 6;
+constexpr qreal imageHeight = 30;
+constexpr qreal pluginHeight = 20;
+
+const char* const conditionKey = "visible";
+
+} // namespace
+
+TemplateGenerator::Config TemplateGenerator::defaultConfig() {
+	return Config{42, 2, 2, 3, 200, 40, QString(), QString()};
+}
+
+TemplateGenerator::TemplateGenerator(Config const& config) :
+	_config(config),
+	_rng(config.seed),
+	_nKeys(0)
+{
+
+}
+
+void TemplateGenerator::generateTemplate(DocumentTemplate & docTemplate) {
+
+	_rng.seed(_config.seed);
+	_nKeys = 0;
+
+	for (int p = 0; p < _config.nPages; p++) {
+
+		DocumentItem* page = new DocumentItem(DocumentItem::Page, &docTemplate);
+		page->setInitialWidth(pageWidth);
+		page->setInitialHeight(pageHeight);
+		page->setDataKey(QString("page%1").arg(p+1));
+		page->setObjectName(QString("Page %1").arg(p+1));
+
+		docTemplate.insertSubItem(page);
+
+		//same structure as a page with a repeating header: a frame copied on each page, containing the header and the loop.
+		DocumentItem* frame = newItem(DocumentItem::Frame, page, pageWidth, pageHeight);
+		frame->setOverflowBehavior(DocumentItem::CopyOnNewPages);
+
+		GeneratedItem header = generateTree(frame, _config.depth, pageWidth);
+		header.item->setOverflowBehavior(DocumentItem::CopyOnNewPages);
+
+		DocumentItem* loop = newItem(DocumentItem::Loop, frame, pageWidth, 0);
+		loop->setPosY(header.height);
+		loop->setMaxHeight(pageHeight - header.height);
+		loop->setOverflowBehavior(DocumentItem::OverflowOnNewPage);
+
+		GeneratedItem delegate = generateTree(loop, _config.depth, pageWidth);
+		loop->setInitialHeight(delegate.height);
+	}
+}
+
+QJsonObject TemplateGenerator::generateData(DocumentTemplate const& docTemplate) {
+
+	_rng.seed(_config.seed + 1);
+
+	QJsonObject data;
+
+	for (DocumentItem* item : docTemplate.subitems()) {
+		if (item == nullptr) {
+			continue;
+		}
+
+		data.insert(item->dataKey(), itemData(item));
+	}
+
+	return data;
+}
+
+TemplateGenerator::GeneratedItem TemplateGenerator::generateTree(DocumentItem* parent, int depth, qreal width) {
+
+	if (depth <= 0) {
+		return generateLeaf(parent, width);
+	}
+
+	int type = randomInt(3);
+
+	if (type == 0) { //conditions are small, they only wrap one or two trees.
+
+		DocumentItem* condition = newItem(DocumentItem::Condition, parent, width, 0);
+		condition->setData(conditionKey);
+
+		qreal height = 0;
+		int nSubitems = 1 + randomInt(2);
+
+		for (int i = 0; i < nSubitems; i++) {
+			GeneratedItem sub = generateTree(condition, depth-1, width);
+			height = std::max(height, sub.height);
+		}
+
+		condition->setInitialHeight(height);
+		condition->setMaxHeight(height);
+
+		return GeneratedItem{condition, height};
+	}
+
+	DocumentItem* container = newItem((type == 1) ? DocumentItem::Frame : DocumentItem::List, parent, width, 0);
+
+	if (type == 1) {
+		container->setBorderWidth(0.5);
+	}
+
+	qreal height = 0;
+
+	for (int i = 0; i < _config.breadth; i++) {
+		GeneratedItem sub = generateTree(container, depth-1, width);
+		sub.item->setPosY(height); //frames place their subitems, lists ignore the position
+		height += sub.height;
+	}
+
+	container->setInitialHeight(height);
+	container->setMaxHeight(height);
+
+	return GeneratedItem{container, height};
+}
+
+TemplateGenerator::GeneratedItem TemplateGenerator::generateLeaf(DocumentItem* parent, qreal width) {
+
+	QList<DocumentItem::Type> types;
+	types << DocumentItem::Text;
+
+	if (!_config.imagePath.isEmpty()) {
+		types << DocumentItem::Image;
+	}
+
+	if (!_config.pluginName.isEmpty()) {
+		types << DocumentItem::Plugin;
+	}
+
+	DocumentItem::Type type = types[randomInt(types.size())];
+
+	if (type == DocumentItem::Image) {
+		DocumentItem* image = newItem(DocumentItem::Image, parent, std::min(width, 3*imageHeight), imageHeight);
+		return GeneratedItem{image, imageHeight};
+	}
+
+	if (type == DocumentItem::Plugin) {
+		DocumentItem* plugin = newItem(DocumentItem::Plugin, parent, width, pluginHeight);
+		plugin->setData(_config.pluginName);
+		return GeneratedItem{plugin, pluginHeight};
+	}
+
+	DocumentItem* text = newItem(DocumentItem::Text, parent, width, textHeight);
+	text->setFontName("sans");
+	text->setFontSize(textFontSize);
+
+	return GeneratedItem{text, textHeight};
+}
+
+DocumentItem* TemplateGenerator::newItem(int type, DocumentItem* parent, qreal width, qreal height) {
+
+	DocumentItem* item = new DocumentItem(static_cast<DocumentItem::Type>(type), parent);
+	item->setPosX(0);
+	item->setPosY(0);
+	item->setInitialWidth(width);
+	item->setInitialHeight(height);
+	item->setMaxWidth(width);
+	item->setMaxHeight(height);
+
+	_nKeys++;
+	item->setDataKey(QString("k%1").arg(_nKeys));
+	item->setObjectName(QString("%1 %2").arg(DocumentItem::typeToString(item->getType())).arg(_nKeys));
+
+	parent->insertSubItem(item);
+
+	return item;
+}
+
+QJsonValue TemplateGenerator::itemData(DocumentItem* item) {
+
+	switch (item->getType()) {
+	case DocumentItem::Text:
+		return randomText();
+	case DocumentItem::Image:
+		return _config.imagePath;
+	case DocumentItem::Plugin:
+		return QString("plugin data %1").arg(randomInt(1000));
+	case DocumentItem::Loop:
+	{
+		QJsonArray rows;
+
+		DocumentItem* delegate = (item->subitems().isEmpty()) ? nullptr : item->subitems()[0];
+
+		if (delegate == nullptr) {
+			return rows;
+		}
+
+		for (int i = 0; i < _config.nRows; i++) {
+			rows.push_back(itemData(delegate)); //the delegates get the array elements directly
+		}
+
+		return rows;
+	}
+	case DocumentItem::Condition:
+	{
+		QJsonObject obj = subitemsData(item);
+		obj.insert(conditionKey, randomInt(4) != 0);
+		return obj;
+	}
+	default:
+		return subitemsData(item);
+	}
+}
+
+QJsonObject TemplateGenerator::subitemsData(DocumentItem* item) {
+
+	QJsonObject obj;
+
+	for (DocumentItem* subitem : item->subitems()) {
+		if (subitem == nullptr) {
+			continue;
+		}
+
+		obj.insert(subitem->dataKey(), itemData(subitem));
+	}
+
+	return obj;
+}
+
+QString TemplateGenerator::randomText() {
+
+	static const QStringList words = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur",
+									  "adipiscing", "elit", "sed", "do", "eiusmod", "tempor",
+									  "incididunt", "ut", "labore", "et", "dolore", "magna", "aliqua"};
+
+	QString text;
+	text.reserve(_config.textLength + 16);
+
+	while (text.size() < _config.textLength) {
+		if (!text.isEmpty()) {
+			text += ' ';
+		}
+		text += words[randomInt(words.size())];
+	}
+
+	return text;
+}
+
+int TemplateGenerator::randomInt(int max) {
+	if (max <= 1) {
+		return 0;
+	}
+	return static_cast<int>(_rng() % static_cast<quint32>(max));
+}
+
+} // namespace AutoQuill
@@ -0,0 +1,85 @@
+#ifndef TEMPLATEGENERATOR_H
+#define TEMPLATEGENERATOR_H
+
+#include <QString>
+#include <QJsonObject>
+#include <QJsonValue>
+
+#include <random>
+
+namespace AutoQuill {
+
+class DocumentTemplate;
+class DocumentItem;
+
+/*!
+ * \brief The TemplateGenerator class build synthetic templates, and matching datasets, for scale testing.
+ *
+ * Each generated page contains a header made of a random tree of frames, lists, conditions and leaves
+ * (texts, and images or plugins when configured), followed by a loop overflowing on new pages whose
+ * delegate is another random tree. The same seed always give the same template and data.
+ *
+ * The header and one delegate have to fit together on a page, so depth and breadth have to stay small
+ * (leaves are between 10 and 30 points high).
+ */
+class TemplateGenerator
+{
+public:
+
+	struct Config {
+		quint32 seed;
+		int nPages; //number of page items in the template
+		int depth; //depth of the random trees of items
+		int breadth; //number of subitems of the containers in the random trees, a tree has up to breadth^depth leaves
+		int nRows; //number of rows of each loop in the dataset
+		int textLength; //approximate length of the texts in the dataset, in characters
+		QString imagePath; //path of the image used by image items, no image items are generated if empty
+		QString pluginName; //plugin used by plugin items, no plugin items are generated if empty
+	};
+
+	/*!
+	 * \brief defaultConfig give a small configuration, which can be laid out in a few pages.
+	 */
+	static Config defaultConfig();
+
+	explicit TemplateGenerator(Config const& config);
+
+	/*!
+	 * \brief generateTemplate add the generated items to a template
+	 * \param docTemplate the template to fill.
+	 */
+	void generateTemplate(DocumentTemplate & docTemplate);
+
+	/*!
+	 * \brief generateData build a dataset for a template
+	 * \param docTemplate a template built by generateTemplate (with the same config).
+	 * \return the data, to use with a JsonDocumentDataInterface.
+	 */
+	QJsonObject generateData(DocumentTemplate const& docTemplate);
+
+protected:
+
+	struct GeneratedItem {
+		DocumentItem* item;
+		qreal height;
+	};
+
+	GeneratedItem generateTree(DocumentItem* parent, int depth, qreal width);
+	GeneratedItem generateLeaf(DocumentItem* parent, qreal width);
+
+	DocumentItem* newItem(int type, DocumentItem* parent, qreal width, qreal height);
+
+	QJsonValue itemData(DocumentItem* item);
+	QJsonObject subitemsData(DocumentItem* item);
+	QString randomText();
+
+	int randomInt(int max);
+
+	Config _config;
+	std::mt19937 _rng;
+	int _nKeys;
+};
+
+} // namespace AutoQuill
+
+#endif // TEMPLATEGENERATOR_H
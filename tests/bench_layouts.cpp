@@ -0,0 +1,483 @@
+#include <QTest>
+
+#include "../lib/jsondocumentdatainterface.h"
+#include "../lib/documenttemplate.h"
+#include "../lib/documentitem.h"
+#include "../lib/documentrenderer.h"
+#include "../lib/renderplugin.h"
+#include "../lib/templategenerator.h"
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#include <QPainter>
+#include <QPdfWriter>
+#include <QIODevice>
+#include <QImage>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+class NullDevice : public QIODevice {
+    Q_OBJECT
+public:
+    explicit NullDevice(QObject *parent = nullptr) : QIODevice(parent) {}
+
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override {
+        Q_UNUSED(data);
+        Q_UNUSED(maxSize);
+        return -1;
+    }
+
+    qint64 writeData(const char *data, qint64 maxSize) override {
+        Q_UNUSED(data);
+        return maxSize;
+    }
+};
+
+/*!
+ * \brief The BenchLayouts class measure the layout and render time of typical templates.
+ *
+ * ctest only run it as a smoke test, with AUTOQUILL_BENCH_SMOKE set to reduce the size of the cases,
+ * run the benchLayouts executable manually for the actual measures.
+ * Besides the QBENCHMARK output, a json summary of each case (layout ms, render ms, pages/s and peak memory)
+ * is written to the file given by the AUTOQUILL_BENCH_OUTPUT environment variable (benchLayouts.json by default).
+ */
+class BenchLayouts : public QObject {
+
+    Q_OBJECT
+private Q_SLOTS:
+
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchLoopLayout_data();
+    void benchLoopLayout();
+
+    void benchTextHeavyLayout();
+    void benchImageHeavyRender();
+    void benchNestedLayout();
+    void benchConditionsLayout();
+
+    void benchPdfRender_data();
+    void benchPdfRender();
+
+    void benchGeneratedRender_data();
+    void benchGeneratedRender();
+
+private:
+
+    static qint64 peakRssKb();
+    static int benchSize(int size);
+
+    static AutoQuill::DocumentItem* addItem(AutoQuill::DocumentItem::Type type,
+                                            AutoQuill::DocumentItem* parent,
+                                            QString const& dataKey,
+                                            QSizeF const& size);
+    static AutoQuill::DocumentItem* addLoopPage(AutoQuill::DocumentTemplate & docTemplate);
+
+    static QJsonObject loopData(QJsonArray const& rows);
+
+    void runCase(QString const& name,
+                 AutoQuill::DocumentTemplate const& docTemplate,
+                 QJsonObject const& data,
+                 bool renderPdf);
+
+    QTemporaryDir _tmpDir;
+    QString _imagePath;
+
+    QJsonArray _results;
+};
+
+void BenchLayouts::initTestCase() {
+
+    QVERIFY(_tmpDir.isValid());
+
+    QImage image(256, 256, QImage::Format_RGB32);
+
+    for (int y = 0; y < image.height(); y++) {
+        for (int x = 0; x < image.width(); x++) {
+            image.setPixel(x, y, qRgb(x, y, (x+y)/2));
+        }
+    }
+
+    _imagePath = _tmpDir.filePath("image.png");
+    QVERIFY(image.save(_imagePath));
+}
+
+void BenchLayouts::cleanupTestCase() {
+
+    QByteArray outPath = qgetenv("AUTOQUILL_BENCH_OUTPUT");
+
+    if (outPath.isEmpty()) {
+        outPath = "benchLayouts.json";
+    }
+
+    QByteArray json = QJsonDocument(_results).toJson();
+
+    QFile out(QString::fromLocal8Bit(outPath));
+
+    if (!out.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write benchmark results to" << out.fileName();
+        return;
+    }
+
+    out.write(json);
+    out.close();
+}
+
+int BenchLayouts::benchSize(int size) {
+
+    static const bool smoke = qEnvironmentVariableIsSet("AUTOQUILL_BENCH_SMOKE");
+
+    if (smoke) {
+        return std::min(size, 100);
+    }
+
+    return size;
+}
+
+void BenchLayouts::benchLoopLayout_data() {
+
+    QTest::addColumn<int>("nRows");
+
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void BenchLayouts::benchLoopLayout() {
+
+    QFETCH(int, nRows);
+    nRows = benchSize(nRows);
+
+    AutoQuill::DocumentTemplate docTemplate;
+    AutoQuill::DocumentItem* loop = addLoopPage(docTemplate);
+    addItem(AutoQuill::DocumentItem::Text, loop, "", QSizeF(595, 8))->setFontSize(6);
+
+    QJsonArray rows;
+
+    for (int i = 0; i < nRows; i++) {
+        rows.push_back(QString("Row %1").arg(i+1)); //the loop delegate get the array elements directly
+    }
+
+    runCase(QString("loop_%1").arg(QTest::currentDataTag()), docTemplate, loopData(rows), false);
+}
+
+void BenchLayouts::benchTextHeavyLayout() {
+
+    const int nRows = benchSize(2000);
+
+    AutoQuill::DocumentTemplate docTemplate;
+    AutoQuill::DocumentItem* loop = addLoopPage(docTemplate);
+
+    AutoQuill::DocumentItem* text = addItem(AutoQuill::DocumentItem::Text, loop, "", QSizeF(595, 20));
+    text->setMaxHeight(400);
+    text->setTextAlign(AutoQuill::DocumentItem::AlignJustify);
+
+    QString paragraph = QString("Lorem ipsum dolor sit amet, consectetur adipiscing elit, "
+                                "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. ").repeated(6);
+
+    QJsonArray rows;
+
+    for (int i = 0; i < nRows; i++) {
+        rows.push_back(QString("%1. %2").arg(i+1).arg(paragraph));
+    }
+
+    runCase("text_heavy", docTemplate, loopData(rows), false);
+}
+
+void BenchLayouts::benchImageHeavyRender() {
+
+    const int nRows = benchSize(2000);
+
+    AutoQuill::DocumentTemplate docTemplate;
+    AutoQuill::DocumentItem* loop = addLoopPage(docTemplate);
+
+    addItem(AutoQuill::DocumentItem::Image, loop, "", QSizeF(595, 100));
+
+    QJsonArray rows;
+
+    for (int i = 0; i < nRows; i++) {
+        rows.push_back(_imagePath);
+    }
+
+    runCase("image_heavy", docTemplate, loopData(rows), true);
+}
+
+void BenchLayouts::benchNestedLayout() {
+
+    const int nRows = benchSize(5000);
+
+    AutoQuill::DocumentTemplate docTemplate;
+    AutoQuill::DocumentItem* loop = addLoopPage(docTemplate);
+
+    AutoQuill::DocumentItem* list = addItem(AutoQuill::DocumentItem::List, loop, "", QSizeF(595, 30));
+    AutoQuill::DocumentItem* frame = addItem(AutoQuill::DocumentItem::Frame, list, "frame", QSizeF(595, 30));
+    frame->setBorderWidth(0.5);
+
+    AutoQuill::DocumentItem* innerList = addItem(AutoQuill::DocumentItem::List, frame, "cells", QSizeF(595, 30));
+    innerList->setDirection(AutoQuill::DocumentItem::Left2Right);
+
+    addItem(AutoQuill::DocumentItem::Text, innerList, "title", QSizeF(200, 15))->setFontSize(8);
+    addItem(AutoQuill::DocumentItem::Text, innerList, "value", QSizeF(200, 15))->setFontSize(8);
+
+    QJsonArray rows;
+
+    for (int i = 0; i < nRows; i++) {
+        QJsonObject cells;
+        cells.insert("title", QString("Title %1").arg(i+1));
+        cells.insert("value", QString::number(i*3.5));
+
+        QJsonObject row;
+        row.insert("frame", QJsonObject{{"cells", cells}});
+        rows.push_back(row);
+    }
+
+    runCase("nested", docTemplate, loopData(rows), false);
+}
+
+void BenchLayouts::benchConditionsLayout() {
+
+    const int nRows = benchSize(20000);
+
+    AutoQuill::DocumentTemplate docTemplate;
+    AutoQuill::DocumentItem* loop = addLoopPage(docTemplate);
+
+    AutoQuill::DocumentItem* condition = addItem(AutoQuill::DocumentItem::Condition, loop, "", QSizeF(595, 10));
+    condition->setData("show");
+
+    addItem(AutoQuill::DocumentItem::Text, condition, "text", QSizeF(595, 10))->setFontSize(6);
+    addItem(AutoQuill::DocumentItem::Frame, condition, "", QSizeF(595, 4));
+
+    QJsonArray rows;
+
+    for (int i = 0; i < nRows; i++) {
+        QJsonObject row;
+        row.insert("show", i%3 != 0);
+        row.insert("text", QString("Row %1").arg(i+1));
+        rows.push_back(row);
+    }
+
+    runCase("conditions", docTemplate, loopData(rows), false);
+}
+
+void BenchLayouts::benchPdfRender_data() {
+
+    QTest::addColumn<int>("nRows");
+
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+}
+
+void BenchLayouts::benchPdfRender() {
+
+    QFETCH(int, nRows);
+    nRows = benchSize(nRows);
+
+    AutoQuill::DocumentTemplate docTemplate;
+    AutoQuill::DocumentItem* loop = addLoopPage(docTemplate);
+
+    AutoQuill::DocumentItem* frame = addItem(AutoQuill::DocumentItem::Frame, loop, "", QSizeF(595, 12));
+    frame->setBorderWidth(0.5);
+    frame->setFillColor(QColor(240, 240, 240));
+
+    addItem(AutoQuill::DocumentItem::Text, frame, "text", QSizeF(595, 12))->setFontSize(8);
+
+    QJsonArray rows;
+
+    for (int i = 0; i < nRows; i++) {
+        QJsonObject row;
+        row.insert("text", QString("Row %1").arg(i+1));
+        rows.push_back(row);
+    }
+
+    runCase(QString("pdf_%1").arg(QTest::currentDataTag()), docTemplate, loopData(rows), true);
+}
+
+void BenchLayouts::benchGeneratedRender_data() {
+
+    QTest::addColumn<int>("depth");
+    QTest::addColumn<int>("breadth");
+    QTest::addColumn<int>("nRows");
+
+    QTest::newRow("shallow") << 1 << 4 << 10000;
+    QTest::newRow("deep") << 4 << 2 << 2000;
+    QTest::newRow("wide") << 2 << 6 << 1000;
+}
+
+void BenchLayouts::benchGeneratedRender() {
+
+    QFETCH(int, depth);
+    QFETCH(int, breadth);
+    QFETCH(int, nRows);
+    nRows = benchSize(nRows);
+
+    AutoQuill::TemplateGenerator::Config config = AutoQuill::TemplateGenerator::defaultConfig();
+    config.depth = depth;
+    config.breadth = breadth;
+    config.nRows = nRows;
+    config.imagePath = _imagePath;
+
+    AutoQuill::TemplateGenerator generator(config);
+
+    AutoQuill::DocumentTemplate docTemplate;
+    generator.generateTemplate(docTemplate);
+
+    runCase(QString("generated_%1").arg(QTest::currentDataTag()), docTemplate, generator.generateData(docTemplate), true);
+}
+
+qint64 BenchLayouts::peakRssKb() {
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#ifdef Q_OS_MACOS
+    return usage.ru_maxrss/1024; //bytes on macos
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+AutoQuill::DocumentItem* BenchLayouts::addItem(AutoQuill::DocumentItem::Type type,
+                                               AutoQuill::DocumentItem* parent,
+                                               QString const& dataKey,
+                                               QSizeF const& size) {
+
+    AutoQuill::DocumentItem* item = new AutoQuill::DocumentItem(type, parent);
+    item->setInitialWidth(size.width());
+    item->setInitialHeight(size.height());
+    item->setMaxWidth(size.width());
+    item->setMaxHeight(size.height());
+    item->setDataKey(dataKey);
+    item->setFontName("sans");
+
+    parent->insertSubItem(item);
+
+    return item;
+}
+
+AutoQuill::DocumentItem* BenchLayouts::addLoopPage(AutoQuill::DocumentTemplate & docTemplate) {
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &docTemplate);
+    page->setInitialWidth(595);
+    page->setInitialHeight(842);
+    page->setDataKey("page");
+    page->setObjectName("Page");
+
+    docTemplate.insertSubItem(page);
+
+    AutoQuill::DocumentItem* loop = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Loop, page);
+    loop->setPosX(0);
+    loop->setPosY(0);
+    loop->setInitialWidth(595);
+    loop->setInitialHeight(842);
+    loop->setDataKey("rows");
+    loop->setObjectName("Loop");
+    loop->setOverflowBehavior(AutoQuill::DocumentItem::OverflowBehavior::OverflowOnNewPage);
+
+    page->insertSubItem(loop);
+
+    return loop;
+}
+
+QJsonObject BenchLayouts::loopData(QJsonArray const& rows) {
+
+    QJsonObject page;
+    page.insert("rows", rows);
+
+    QJsonObject data;
+    data.insert("page", page);
+
+    return data;
+}
+
+void BenchLayouts::runCase(QString const& name,
+                           AutoQuill::DocumentTemplate const& docTemplate,
+                           QJsonObject const& data,
+                           bool renderPdf) {
+
+    AutoQuill::JsonDocumentDataInterface dataInterface(data);
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::DocumentRenderer renderer(docTemplate);
+
+    qint64 layoutNs = 0;
+    qint64 renderNs = 0;
+    int nPages = 0;
+    int nIterations = 0;
+
+    QElapsedTimer timer;
+
+    QBENCHMARK {
+        NullDevice layoutDevice;
+        layoutDevice.open(QIODevice::WriteOnly);
+
+        QPdfWriter writer(&layoutDevice);
+        writer.setResolution(72);
+        writer.setPageMargins(QMarginsF(0,0,0,0));
+
+        QPainter painter(&writer);
+
+        timer.start();
+        AutoQuill::DocumentRenderer::LayoutResults results = renderer.layoutHeadless(&dataInterface, pluginManager, &painter);
+        layoutNs += timer.nsecsElapsed();
+
+        if (results.status.status != AutoQuill::DocumentRenderer::Status::Success) {
+            qWarning() << "Error while laying out the document: " << results.status.message;
+        }
+
+        QCOMPARE(results.status.status, AutoQuill::DocumentRenderer::Status::Success);
+
+        nPages = AutoQuill::DocumentRenderer::getLayoutNPages(results.layout.items());
+
+        if (renderPdf) {
+            NullDevice device;
+            device.open(QIODevice::WriteOnly);
+
+            timer.start();
+            AutoQuill::DocumentRenderer::RenderingStatus status = renderer.render(results.layout, pluginManager, &device);
+            renderNs += timer.nsecsElapsed();
+
+            QCOMPARE(status.status, AutoQuill::DocumentRenderer::Status::Success);
+        }
+
+        painter.end();
+        nIterations++;
+    }
+
+    double layoutMs = layoutNs/1e6/nIterations;
+    double renderMs = renderNs/1e6/nIterations;
+
+    QJsonObject result;
+    result.insert("case", name);
+    result.insert("iterations", nIterations);
+    result.insert("pages", nPages);
+    result.insert("layout_ms", layoutMs);
+    result.insert("render_ms", renderPdf ? QJsonValue(renderMs) : QJsonValue());
+    result.insert("pages_per_s", (layoutMs + renderMs > 0) ? nPages*1000./(layoutMs + renderMs) : 0.);
+    result.insert("peak_rss_kb", peakRssKb()); //peak of the whole process so far, cases are run from the smallest.
+
+    _results.push_back(result);
+
+    qDebug() << QJsonDocument(result).toJson(QJsonDocument::Compact).constData();
+}
+
+#include "bench_layouts.moc"
+
+QTEST_MAIN(BenchLayouts)
@@ -0,0 +1,147 @@
+#include <QTest>
+#include <QCoreApplication>
+
+#include "../lib/documenttemplate.h"
+#include "../lib/documentitem.h"
+
+#include <QJsonDocument>
+#include <QJsonArray>
+
+/*!
+ * \brief The BenchTemplateIO class compare the json and binary template formats on a large, machine generated, template.
+ *
+ * ctest only run it once as a smoke test, run the benchTemplateIO executable manually for the actual measures.
+ */
+class BenchTemplateIO : public QObject {
+
+    Q_OBJECT
+private Q_SLOTS:
+
+    void initTestCase();
+
+    void benchJsonSave();
+    void benchJsonLoad();
+
+    void benchBinarySave();
+    void benchBinaryLoad();
+
+private:
+
+    void flushDeletedItems();
+
+    static constexpr int nPages = 100;
+    static constexpr int nRowsPerPage = 100;
+
+    AutoQuill::DocumentTemplate _template;
+
+    QByteArray _jsonData;
+    QByteArray _binaryData;
+};
+
+constexpr int BenchTemplateIO::nPages;
+constexpr int BenchTemplateIO::nRowsPerPage;
+
+void BenchTemplateIO::initTestCase() {
+
+    for (int p = 0; p < nPages; p++) {
+
+        AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &_template);
+        page->setInitialWidth(595);
+        page->setInitialHeight(842);
+        page->setObjectName(QString("Page %1").arg(p+1));
+
+        _template.insertSubItem(page);
+
+        AutoQuill::DocumentItem* list = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::List, page);
+        list->setInitialWidth(595);
+        list->setInitialHeight(842);
+        list->setObjectName("List");
+
+        page->insertSubItem(list);
+
+        for (int r = 0; r < nRowsPerPage; r++) {
+
+            AutoQuill::DocumentItem* frame = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Frame, list);
+            frame->setInitialWidth(595);
+            frame->setInitialHeight(8);
+            frame->setBorderWidth(0.5);
+            frame->setFillColor(QColor(240, 240, 240));
+            frame->setObjectName(QString("Row %1").arg(r+1));
+
+            list->insertSubItem(frame);
+
+            AutoQuill::DocumentItem* text = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, frame);
+            text->setInitialWidth(595);
+            text->setInitialHeight(8);
+            text->setFontName("sans");
+            text->setFontSize(6);
+            text->setDataKey(QString("row_%1").arg(r));
+            text->setObjectName("Text");
+
+            frame->insertSubItem(text);
+        }
+    }
+
+    _jsonData = QJsonDocument(_template.encapsulateToJson().toArray()).toJson();
+    _binaryData = _template.encapsulateToBinary();
+
+    qDebug() << "Template with" << nPages*(2+2*nRowsPerPage) << "items,"
+             << "json size:" << _jsonData.size() << "bytes,"
+             << "binary size:" << _binaryData.size() << "bytes";
+}
+
+void BenchTemplateIO::benchJsonSave() {
+
+    QByteArray data;
+
+    QBENCHMARK {
+        data = QJsonDocument(_template.encapsulateToJson().toArray()).toJson();
+    }
+
+    QCOMPARE(data.size(), _jsonData.size());
+}
+
+void BenchTemplateIO::benchJsonLoad() {
+
+    AutoQuill::DocumentTemplate loaded;
+
+    QBENCHMARK {
+        QJsonDocument doc = QJsonDocument::fromJson(_jsonData);
+        loaded.configureFromJson(doc.array());
+        flushDeletedItems();
+    }
+
+    QCOMPARE(loaded.subitems().size(), nPages);
+}
+
+void BenchTemplateIO::benchBinarySave() {
+
+    QByteArray data;
+
+    QBENCHMARK {
+        data = _template.encapsulateToBinary();
+    }
+
+    QCOMPARE(data, _binaryData);
+}
+
+void BenchTemplateIO::benchBinaryLoad() {
+
+    AutoQuill::DocumentTemplate loaded;
+
+    QBENCHMARK {
+        QVERIFY(loaded.configureFromBinary(_binaryData));
+        flushDeletedItems();
+    }
+
+    QCOMPARE(loaded.subitems().size(), nPages);
+}
+
+void BenchTemplateIO::flushDeletedItems() {
+    //templates delete their previous items with deleteLater, which is part of the cost of reloading.
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+#include "bench_template_io.moc"
+
+QTEST_MAIN(BenchTemplateIO)
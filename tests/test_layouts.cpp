@@ -5,14 +5,30 @@
 #include "../lib/documentitem.h"
 #include "../lib/documentrenderer.h"
 #include "../lib/renderplugin.h"
+#include "../lib/templategenerator.h"
+#include "../lib/rendertracer.h"
+#include "../lib/layoutcache.h"
+#include "../lib/outputcache.h"
+#include "../lib/recordingdatainterface.h"
+#include "../lib/renderfarm.h"
 
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonValue>
+#include <QJsonDocument>
 
 #include <QPainter>
 #include <QPdfWriter>
 #include <QIODevice>
+#include <QAtomicInt>
+#include <QSet>
+#include <QThread>
+#include <QTemporaryDir>
+#include <QImageReader>
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QtNumeric>
 
 class NullDevice : public QIODevice {
     Q_OBJECT
@@ -34,6 +50,143 @@ protected:
     }
 };
 
+class ThreadSafeBoxPlugin : public AutoQuill::RenderPlugin {
+public:
+
+    ThreadSafeBoxPlugin() :
+        nCalls(0),
+        nCallsFromOtherThreads(0)
+    {
+
+    }
+
+    QRectF getMinimalSpace(QRectF const& availableSpace, AutoQuill::DocumentValue const& val) const override {
+        Q_UNUSED(val);
+        return QRectF(availableSpace.topLeft(), QSizeF(50, 20));
+    }
+
+    AutoQuill::DocumentRenderer::RenderingStatus renderItem(QRectF const& area, QPainter & painter, AutoQuill::DocumentValue const& val) const override {
+        Q_UNUSED(val);
+        painter.drawRect(area);
+
+        nCalls.fetchAndAddOrdered(1);
+        if (QThread::currentThread() != qApp->thread()) {
+            nCallsFromOtherThreads.fetchAndAddOrdered(1);
+        }
+
+        return AutoQuill::DocumentRenderer::RenderingStatus{AutoQuill::DocumentRenderer::Success, "", area.size()};
+    }
+
+    bool isThreadSafe() const override {
+        return true;
+    }
+
+    mutable QAtomicInt nCalls;
+    mutable QAtomicInt nCallsFromOtherThreads;
+};
+
+class PreparedBoxData : public AutoQuill::PluginPreparedData {
+public:
+    QSizeF size;
+};
+
+class PreparedBoxPlugin : public AutoQuill::PreparedRenderPlugin {
+public:
+
+    PreparedBoxPlugin() :
+        nPrepare(0),
+        nRenderWithPrepared(0)
+    {
+
+    }
+
+    QSharedPointer<const AutoQuill::PluginPreparedData> prepare(AutoQuill::DocumentValue const& val) const override {
+        Q_UNUSED(val);
+        nPrepare.fetchAndAddOrdered(1);
+
+        PreparedBoxData* data = new PreparedBoxData();
+        data->size = QSizeF(40, 40);
+        return QSharedPointer<const AutoQuill::PluginPreparedData>(data);
+    }
+
+    QRectF getPreparedMinimalSpace(QRectF const& availableSpace, AutoQuill::PluginPreparedData const* prepared) const override {
+        return QRectF(availableSpace.topLeft(), static_cast<PreparedBoxData const*>(prepared)->size);
+    }
+
+    AutoQuill::DocumentRenderer::RenderingStatus renderPreparedItem(QRectF const& area, QPainter & painter, AutoQuill::PluginPreparedData const* prepared) const override {
+        if (prepared != nullptr) {
+            nRenderWithPrepared.fetchAndAddOrdered(1);
+        }
+        painter.drawRect(area);
+        return AutoQuill::DocumentRenderer::RenderingStatus{AutoQuill::DocumentRenderer::Success, "", area.size()};
+    }
+
+    QByteArray valueHash(AutoQuill::DocumentValue const& val) const override {
+        Q_UNUSED(val);
+        return QByteArray("box"); //all the items share the same value
+    }
+
+    mutable QAtomicInt nPrepare;
+    mutable QAtomicInt nRenderWithPrepared;
+};
+
+class AreaRecorderPlugin : public AutoQuill::RenderPlugin {
+public:
+
+    QRectF getMinimalSpace(QRectF const& availableSpace, AutoQuill::DocumentValue const& val) const override {
+        Q_UNUSED(val);
+        return QRectF(availableSpace.topLeft(), QSizeF(50, 20));
+    }
+
+    AutoQuill::DocumentRenderer::RenderingStatus renderItem(QRectF const& area, QPainter & painter, AutoQuill::DocumentValue const& val) const override {
+        Q_UNUSED(painter);
+        Q_UNUSED(val);
+        areas.push_back(area);
+        return AutoQuill::DocumentRenderer::RenderingStatus{AutoQuill::DocumentRenderer::Success, "", area.size()};
+    }
+
+    mutable QVector<QRectF> areas;
+};
+
+class PainterProbePlugin : public AutoQuill::RenderPlugin {
+public:
+
+    explicit PainterProbePlugin(bool threadSafe) :
+        threadSafe(threadSafe),
+        dpiX(0),
+        dpiY(0)
+    {
+
+    }
+
+    QRectF getMinimalSpace(QRectF const& availableSpace, AutoQuill::DocumentValue const& val) const override {
+        Q_UNUSED(val);
+        return QRectF(availableSpace.topLeft(), QSizeF(50, 20));
+    }
+
+    AutoQuill::DocumentRenderer::RenderingStatus renderItem(QRectF const& area, QPainter & painter, AutoQuill::DocumentValue const& val) const override {
+        Q_UNUSED(val);
+
+        dpiX = painter.device()->logicalDpiX();
+        dpiY = painter.device()->logicalDpiY();
+        renderHints = painter.renderHints();
+
+        painter.fillRect(area, QColor(0, 0, 0));
+
+        return AutoQuill::DocumentRenderer::RenderingStatus{AutoQuill::DocumentRenderer::Success, "", area.size()};
+    }
+
+    bool isThreadSafe() const override {
+        return threadSafe;
+    }
+
+    bool threadSafe;
+
+    mutable int dpiX;
+    mutable int dpiY;
+    mutable QPainter::RenderHints renderHints;
+};
+
 class TestLayouts : public QObject {
 
     Q_OBJECT
@@ -45,6 +198,38 @@ private Q_SLOTS:
     void testLoopWithHeaderLayout();
     void testLoopWithRepeatingHeaderLayout();
 
+    void testThreadSafePluginRender();
+    void testThreadSafePluginOutput();
+    void testPreparedPluginCache();
+
+    void testRenderToImages();
+
+    void testBinaryTemplateRoundTrip();
+    void testReferenceIndex();
+    void testItemRows();
+
+    void testGeneratedTemplates_data();
+    void testGeneratedTemplates();
+
+    void testRenderTracer();
+
+    void testRenderStatistics();
+    void testMemoryBudget();
+
+    void testLayoutSerialization();
+    void testLayoutCache();
+    void testOutputCache();
+    void testRenderFarm();
+    void testRenderPageRange();
+    void testLayoutCursor();
+    void testDiagnostics();
+    void testImagePrefetcher();
+    void testRelativeCoordinates();
+    void testLoopExpandedRows();
+    void testPagesParentsOffset();
+    void testTextMeasurementsReuse();
+    void testMovedTextMeasurementsReuse();
+
 private:
 
 };
@@ -495,6 +680,1498 @@ void TestLayouts::testLoopWithRepeatingHeaderLayout() {
     }
 }
 
+void TestLayouts::testThreadSafePluginRender() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    ThreadSafeBoxPlugin* plugin = new ThreadSafeBoxPlugin();
+    pluginManager.registerPlugin("box", plugin);
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setInitialWidth(595);
+    page->setInitialHeight(842);
+    page->setObjectName("Page");
+
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* list = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::List, page);
+    list->setPosX(0);
+    list->setPosY(0);
+    list->setInitialWidth(595);
+    list->setInitialHeight(842);
+    list->setObjectName("List");
+
+    page->insertSubItem(list);
+
+    constexpr int nPlugins = 3;
+
+    for (int i = 0; i < nPlugins; i++) {
+        AutoQuill::DocumentItem* pluginItem = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Plugin, list);
+        pluginItem->setData("box");
+        pluginItem->setObjectName(QString("Box %1").arg(i+1));
+
+        list->insertSubItem(pluginItem);
+    }
+
+    AutoQuill::JsonDocumentDataInterface data_interface{QJsonObject()};
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    auto renderStatus = renderer.render(&data_interface, pluginManager, &device);
+
+    if (renderStatus.status != AutoQuill::DocumentRenderer::Status::Success) {
+        qWarning() << "Error while rendering the document: " << renderStatus.message;
+    }
+
+    QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(plugin->nCalls.loadAcquire(), nPlugins);
+    QCOMPARE(plugin->nCallsFromOtherThreads.loadAcquire(), nPlugins);
+}
+
+void TestLayouts::testThreadSafePluginOutput() {
+
+    QVector<QImage> images;
+
+    for (bool threadSafe : {false, true}) {
+
+        AutoQuill::DocumentTemplate doc_template;
+        AutoQuill::RenderPluginManager pluginManager;
+
+        PainterProbePlugin* plugin = new PainterProbePlugin(threadSafe);
+        pluginManager.registerPlugin("probe", plugin);
+
+        AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+        page->setInitialWidth(200);
+        page->setInitialHeight(100);
+        page->setObjectName("Page");
+        doc_template.insertSubItem(page);
+
+        AutoQuill::DocumentItem* pluginItem = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Plugin, page);
+        pluginItem->setPosX(10);
+        pluginItem->setPosY(10);
+        pluginItem->setInitialWidth(50);
+        pluginItem->setInitialHeight(20);
+        pluginItem->setData("probe");
+        pluginItem->setObjectName("Probe");
+        page->insertSubItem(pluginItem);
+
+        AutoQuill::JsonDocumentDataInterface data_interface{QJsonObject()};
+
+        NullDevice device;
+        device.open(QIODevice::WriteOnly);
+
+        QPdfWriter writer(&device);
+        writer.setResolution(72);
+        writer.setPageMargins(QMarginsF(0,0,0,0));
+
+        QPainter tmpPainter(&writer);
+
+        AutoQuill::DocumentRenderer renderer(doc_template);
+        auto results = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+        QCOMPARE(results.status.status, AutoQuill::DocumentRenderer::Status::Success);
+
+        //a resolution different from the default one of a QPicture
+        QImage image(200, 100, QImage::Format_ARGB32_Premultiplied);
+        image.setDotsPerMeterX(qRound(150/0.0254));
+        image.setDotsPerMeterY(qRound(150/0.0254));
+        image.fill(QColor(255, 255, 255));
+
+        QPainter painter(&image);
+        painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+        auto renderStatus = renderer.renderItemToExternalPainter(*results.layout[0], &painter);
+        painter.end();
+
+        QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+
+        QCOMPARE(plugin->dpiX, image.logicalDpiX());
+        QCOMPARE(plugin->dpiY, image.logicalDpiY());
+        QVERIFY(plugin->renderHints.testFlag(QPainter::Antialiasing));
+        QVERIFY(plugin->renderHints.testFlag(QPainter::TextAntialiasing));
+
+        images.push_back(image);
+    }
+
+    //the plugin draws the same on a worker thread as on the document painter
+    QCOMPARE(images[1], images[0]);
+}
+
+void TestLayouts::testPreparedPluginCache() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    PreparedBoxPlugin* plugin = new PreparedBoxPlugin();
+    pluginManager.registerPlugin("preparedBox", plugin);
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setInitialWidth(595);
+    page->setInitialHeight(842);
+    page->setObjectName("Page");
+
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* list = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::List, page);
+    list->setPosX(0);
+    list->setPosY(0);
+    list->setInitialWidth(595);
+    list->setInitialHeight(842);
+    list->setObjectName("List");
+
+    page->insertSubItem(list);
+
+    constexpr int nPlugins = 4;
+
+    for (int i = 0; i < nPlugins; i++) {
+        AutoQuill::DocumentItem* pluginItem = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Plugin, list);
+        pluginItem->setData("preparedBox");
+        pluginItem->setObjectName(QString("Box %1").arg(i+1));
+
+        list->insertSubItem(pluginItem);
+    }
+
+    AutoQuill::JsonDocumentDataInterface data_interface{QJsonObject()};
+
+    constexpr int nDocuments = 2;
+
+    for (int i = 0; i < nDocuments; i++) {
+        NullDevice device;
+        device.open(QIODevice::WriteOnly);
+
+        AutoQuill::DocumentRenderer renderer(doc_template);
+        auto renderStatus = renderer.render(&data_interface, pluginManager, &device);
+
+        QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    }
+
+    QCOMPARE(plugin->nPrepare.loadAcquire(), 1); //the prepared data is shared by all items and documents
+    QCOMPARE(plugin->nRenderWithPrepared.loadAcquire(), nDocuments*nPlugins);
+}
+
+void TestLayouts::testRenderToImages() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    constexpr int nPages = 3;
+
+    for (int i = 0; i < nPages; i++) {
+        AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+        page->setInitialWidth(595);
+        page->setInitialHeight(842);
+        page->setObjectName(QString("Page %1").arg(i+1));
+
+        doc_template.insertSubItem(page);
+
+        AutoQuill::DocumentItem* text = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, page);
+        text->setInitialWidth(595);
+        text->setInitialHeight(105);
+        text->setMaxWidth(595);
+        text->setMaxHeight(105);
+        text->setFontName("sans");
+        text->setFontSize(12);
+        text->setData(QString("Page %1").arg(i+1));
+        text->setObjectName("Text");
+
+        page->insertSubItem(text);
+    }
+
+    AutoQuill::JsonDocumentDataInterface data_interface{QJsonObject()};
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    auto layoutResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+
+    QCOMPARE(layoutResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    QTemporaryDir outDir;
+    QVERIFY(outDir.isValid());
+
+    QString pattern = outDir.filePath("page_%1.png");
+
+    auto renderStatus = renderer.renderToImages(layoutResults.layout, pluginManager, pattern, 36, "png");
+
+    if (renderStatus.status != AutoQuill::DocumentRenderer::Status::Success) {
+        qWarning() << "Error while rendering the images: " << renderStatus.message;
+    }
+
+    QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    for (int i = 0; i < nPages; i++) {
+        QImageReader reader(pattern.arg(i+1));
+        QCOMPARE(reader.size(), QSize(298, 421)); //595x842 points at half the resolution, rounded up.
+    }
+
+    //the same layout can still be rendered to pdf afterward.
+    NullDevice pdfDevice;
+    pdfDevice.open(QIODevice::WriteOnly);
+
+    AutoQuill::DocumentLayout layoutCopy = layoutResults.layout;
+    renderStatus = renderer.render(layoutCopy, pluginManager, &pdfDevice);
+
+    QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(AutoQuill::DocumentRenderer::getLayoutNPages(layoutResults.layout.items()), nPages);
+}
+
+void TestLayouts::testBinaryTemplateRoundTrip() {
+
+    AutoQuill::DocumentTemplate doc_template;
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setInitialWidth(595);
+    page->setInitialHeight(842);
+    page->setDataKey("page");
+    page->setObjectName("Page");
+
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* loop = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Loop, page);
+    loop->setPosX(12);
+    loop->setPosY(24);
+    loop->setInitialWidth(500);
+    loop->setInitialHeight(700);
+    loop->setDirection(AutoQuill::DocumentItem::Left2Right);
+    loop->setOverflowBehavior(AutoQuill::DocumentItem::OverflowBehavior::OverflowOnNewPage);
+    loop->setDataKey("loop");
+    loop->setObjectName("Loop");
+
+    page->insertSubItem(loop);
+
+    AutoQuill::DocumentItem* frame = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Frame, loop);
+    frame->setInitialWidth(100);
+    frame->setInitialHeight(50);
+    frame->setBorderWidth(2);
+    frame->setBorderColor(QColor(10, 20, 30));
+    frame->setFillColor(QColor(200, 100, 50, 128));
+    frame->setObjectName("Frame");
+
+    loop->insertSubItem(frame);
+
+    AutoQuill::DocumentItem* text = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, frame);
+    text->setInitialWidth(100);
+    text->setInitialHeight(20);
+    text->setMaxHeight(40);
+    text->setFontName("sans");
+    text->setFontSize(11);
+    text->setFontWeight(AutoQuill::DocumentItem::Bold);
+    text->setTextAlign(AutoQuill::DocumentItem::AlignCenter);
+    text->setDataKey("text");
+    text->setObjectName("Text");
+
+    frame->insertSubItem(text);
+
+    QByteArray binary = doc_template.encapsulateToBinary();
+
+    AutoQuill::DocumentTemplate loaded_template;
+    QVERIFY(loaded_template.configureFromBinary(binary));
+
+    //the binary format has to store exactly what the json format stores.
+    QCOMPARE(loaded_template.encapsulateToJson(), doc_template.encapsulateToJson());
+
+    QVERIFY(!loaded_template.configureFromBinary(binary.left(binary.size()/2)));
+}
+
+void TestLayouts::testReferenceIndex() {
+
+    AutoQuill::DocumentTemplate doc_template;
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* list = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::List, page);
+    page->insertSubItem(list);
+
+    AutoQuill::DocumentItem* text1 = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, list);
+    list->insertSubItem(text1);
+
+    AutoQuill::DocumentItem* text2 = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, list);
+    list->insertSubItem(text2);
+
+    QString ref1 = text1->buildRef();
+    QString ref2 = text2->buildRef();
+
+    QVERIFY(ref1 != ref2);
+    QCOMPARE(doc_template.findByReference(ref1), text1);
+    QCOMPARE(doc_template.findByReference(ref2), text2);
+    QCOMPARE(doc_template.findByReference(list->buildRef()), list);
+
+    list->removeSubItem(0);
+    QCOMPARE(doc_template.findByReference(ref1), static_cast<AutoQuill::DocumentItem*>(nullptr));
+    QCOMPARE(doc_template.findByReference(ref2), text2);
+}
+
+void TestLayouts::testGeneratedTemplates_data() {
+
+    QTest::addColumn<uint>("seed");
+
+    QTest::newRow("seed 1") << 1u;
+    QTest::newRow("seed 2") << 2u;
+    QTest::newRow("seed 3") << 3u;
+}
+
+void TestLayouts::testGeneratedTemplates() {
+
+    QFETCH(uint, seed);
+
+    AutoQuill::TemplateGenerator::Config config = AutoQuill::TemplateGenerator::defaultConfig();
+    config.seed = seed;
+
+    AutoQuill::TemplateGenerator generator(config);
+
+    AutoQuill::DocumentTemplate doc_template;
+    generator.generateTemplate(doc_template);
+    QJsonObject data = generator.generateData(doc_template);
+
+    //the generator is deterministic.
+    AutoQuill::DocumentTemplate other_template;
+    generator.generateTemplate(other_template);
+    QCOMPARE(other_template.encapsulateToJson(), doc_template.encapsulateToJson());
+    QCOMPARE(generator.generateData(other_template), data);
+
+    AutoQuill::RenderPluginManager pluginManager;
+    AutoQuill::JsonDocumentDataInterface data_interface(data);
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    auto renderStatus = renderer.render(&data_interface, pluginManager, &device);
+
+    if (renderStatus.status != AutoQuill::DocumentRenderer::Status::Success) {
+        qWarning() << "Error while rendering the generated document: " << renderStatus.message;
+    }
+
+    QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+}
+
+void TestLayouts::testRenderTracer() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setObjectName("Page");
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* text = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, page);
+    text->setData("Traced");
+    text->setObjectName("Text");
+    page->insertSubItem(text);
+
+    //same name as its sibling, only the reference tell them apart.
+    AutoQuill::DocumentItem* otherText = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, page);
+    otherText->setPosY(30);
+    otherText->setData("Traced too");
+    otherText->setObjectName("Text");
+    page->insertSubItem(otherText);
+
+    AutoQuill::JsonDocumentDataInterface data_interface{QJsonObject()};
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    AutoQuill::RenderTracer tracer;
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    renderer.setTracer(&tracer);
+    auto renderStatus = renderer.render(&data_interface, pluginManager, &device);
+
+    QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    QVector<AutoQuill::RenderTracer::Event> events = tracer.events();
+    QCOMPARE(events.size(), 6); //page and texts, laid out then rendered.
+
+    int nTextEvents = 0;
+    QSet<QString> textRefs;
+
+    for (AutoQuill::RenderTracer::Event const& event : events) {
+        QVERIFY(event.durationNs >= 0);
+        QCOMPARE(event.page, 1);
+
+        if (event.name == "Text") {
+            QCOMPARE(event.path, QString("Page/Text"));
+            textRefs.insert(event.ref);
+            nTextEvents++;
+        }
+    }
+
+    QCOMPARE(nTextEvents, 4);
+    QCOMPARE(textRefs.size(), 2);
+
+    for (QString const& ref : qAsConst(textRefs)) {
+        AutoQuill::DocumentItem* traced = doc_template.findByReference(ref);
+        QVERIFY(traced == text or traced == otherText);
+    }
+
+    QJsonParseError error;
+    QJsonDocument trace = QJsonDocument::fromJson(tracer.toChromeTrace(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QVERIFY(trace.object().value("traceEvents").isArray());
+}
+
+void TestLayouts::testRenderStatistics() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setObjectName("Page");
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* text = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, page);
+    text->setData("One\nTwo");
+    text->setObjectName("Text");
+    page->insertSubItem(text);
+
+    AutoQuill::JsonDocumentDataInterface data_interface{QJsonObject()};
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    auto layoutResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+
+    QCOMPARE(layoutResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    QVERIFY(!layoutResults.status.statistics.isNull());
+
+    AutoQuill::DocumentRenderer::RenderStatistics const& layoutStatistics = layoutResults.statistics;
+    QCOMPARE(layoutStatistics.nodesAllocated, qint64(2)); //the page and the text
+    QVERIFY(layoutStatistics.paragraphsShaped >= 2);
+    QVERIFY(layoutStatistics.linesBroken >= layoutStatistics.paragraphsShaped);
+    QCOMPARE(layoutStatistics.pagesProduced, qint64(1));
+    QCOMPARE(layoutStatistics.bytesWritten, qint64(0));
+    QVERIFY(layoutStatistics.layoutWallNs > 0);
+
+    QBuffer output;
+    auto renderStatus = renderer.render(layoutResults.layout, pluginManager, &output);
+
+    QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QVERIFY(!renderStatus.statistics.isNull());
+
+    AutoQuill::DocumentRenderer::RenderStatistics const& renderStatistics = *renderStatus.statistics;
+    QCOMPARE(renderStatistics.nodesAllocated, qint64(0)); //rendering reuse the layout
+    QCOMPARE(renderStatistics.paragraphsShaped, qint64(2));
+    QCOMPARE(renderStatistics.pagesProduced, qint64(1));
+    QVERIFY(renderStatistics.bytesWritten > 0);
+    QCOMPARE(renderStatistics.bytesWritten, qint64(output.data().size()));
+    QVERIFY(renderStatistics.renderWallNs > 0);
+}
+
+/*!
+ * \brief buildRowsTemplate build a page with a loop of texts overflowing on new pages, and the matching data.
+ */
+static QJsonObject buildRowsTemplate(AutoQuill::DocumentTemplate & doc_template, int nRows) {
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setDataKey("page");
+    page->setObjectName("Page");
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* loop = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Loop, page);
+    loop->setInitialWidth(595);
+    loop->setInitialHeight(842);
+    loop->setDataKey("loop");
+    loop->setObjectName("Loop");
+    loop->setOverflowBehavior(AutoQuill::DocumentItem::OverflowBehavior::OverflowOnNewPage);
+    page->insertSubItem(loop);
+
+    AutoQuill::DocumentItem* text = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, loop);
+    text->setInitialWidth(595);
+    text->setInitialHeight(20);
+    text->setMaxWidth(595);
+    text->setMaxHeight(20);
+    text->setObjectName("Text");
+    loop->insertSubItem(text);
+
+    QJsonArray loop_data;
+
+    for (int i = 0; i < nRows; i++) {
+        loop_data.push_back(QString("Row %1").arg(i+1));
+    }
+
+    QJsonObject page_data;
+    page_data.insert("loop", loop_data);
+
+    QJsonObject layout_data;
+    layout_data.insert("page", page_data);
+
+    return layout_data;
+}
+
+void TestLayouts::testMemoryBudget() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::JsonDocumentDataInterface data_interface(buildRowsTemplate(doc_template, 500));
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    qint64 peakMemory;
+
+    {
+        AutoQuill::DocumentRenderer renderer(doc_template);
+        auto layoutResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+
+        QCOMPARE(layoutResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+        peakMemory = layoutResults.statistics.peakMemoryBytes;
+        QVERIFY(peakMemory > 0);
+    }
+
+    {
+        AutoQuill::DocumentRenderer renderer(doc_template);
+        renderer.setMemoryBudget(2*peakMemory);
+        auto layoutResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+
+        QCOMPARE(layoutResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    }
+
+    {
+        AutoQuill::DocumentRenderer renderer(doc_template);
+        renderer.setMemoryBudget(peakMemory/2);
+        auto layoutResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+
+        QCOMPARE(layoutResults.status.status, AutoQuill::DocumentRenderer::Status::MemoryBudgetExceeded);
+        QVERIFY(layoutResults.status.message.contains(QString::number(peakMemory/2)));
+        QVERIFY(layoutResults.layout.isEmpty());
+        QVERIFY(layoutResults.statistics.peakMemoryBytes <= peakMemory/2 + peakMemory/10); //stopped early
+    }
+}
+
+void TestLayouts::testLayoutSerialization() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::JsonDocumentDataInterface data_interface(buildRowsTemplate(doc_template, 100));
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    auto layoutResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+
+    QCOMPARE(layoutResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    QByteArray encoded = layoutResults.layout.encapsulateToBinary();
+
+    AutoQuill::DocumentLayout decoded;
+    QVERIFY(decoded.configureFromBinary(encoded, doc_template));
+
+    QVector<AutoQuill::ItemRenderInfos*> pages;
+    QVector<AutoQuill::ItemRenderInfos*> decodedPages;
+    AutoQuill::DocumentRenderer::collectLayoutPages(layoutResults.layout.items(), pages);
+    AutoQuill::DocumentRenderer::collectLayoutPages(decoded.items(), decodedPages);
+
+    QVERIFY(pages.size() > 1);
+    QCOMPARE(decodedPages.size(), pages.size());
+
+    for (int p = 0; p < pages.size(); p++) {
+        AutoQuill::ItemRenderInfos* loopInfos = pages[p]->subitemsRenderInfos[0];
+        AutoQuill::ItemRenderInfos* decodedLoopInfos = decodedPages[p]->subitemsRenderInfos[0];
+
+        QCOMPARE(decodedLoopInfos->item, loopInfos->item);
+        QCOMPARE(decodedLoopInfos->continuationIndex, loopInfos->continuationIndex);
+        QCOMPARE(decodedLoopInfos->subitemsRenderInfos.size(), loopInfos->subitemsRenderInfos.size());
+
+        for (int i = 0; i < loopInfos->subitemsRenderInfos.size(); i++) {
+            AutoQuill::ItemRenderInfos* textInfos = loopInfos->subitemsRenderInfos[i];
+            AutoQuill::ItemRenderInfos* decodedTextInfos = decodedLoopInfos->subitemsRenderInfos[i];
+
+            QCOMPARE(decodedTextInfos->currentOrigin, textInfos->currentOrigin);
+            QCOMPARE(decodedTextInfos->currentSize, textInfos->currentSize);
+            QCOMPARE(decodedTextInfos->itemValue.getValue(), textInfos->itemValue.getValue());
+        }
+    }
+
+    QBuffer output;
+    auto renderStatus = renderer.render(decoded, pluginManager, &output);
+    QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    //a layout from another template is rejected
+    AutoQuill::DocumentTemplate other_template;
+    AutoQuill::DocumentLayout rejected;
+    QVERIFY(!rejected.configureFromBinary(encoded, other_template));
+    QVERIFY(rejected.isEmpty());
+}
+
+void TestLayouts::testLayoutCache() {
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::JsonDocumentDataInterface data_interface(buildRowsTemplate(doc_template, 100));
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::LayoutCache cache(dir.path());
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    renderer.setLayoutCache(&cache);
+
+    auto firstResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+    QCOMPARE(firstResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(firstResults.statistics.layoutCacheHits, qint64(0));
+
+    auto secondResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+    QCOMPARE(secondResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(secondResults.statistics.layoutCacheHits, qint64(1));
+    QCOMPARE(secondResults.statistics.nodesAllocated, qint64(0));
+    QCOMPARE(AutoQuill::DocumentRenderer::getLayoutNPages(secondResults.layout.items()),
+             AutoQuill::DocumentRenderer::getLayoutNPages(firstResults.layout.items()));
+
+    //other data give another key
+    AutoQuill::DocumentTemplate other_template;
+    AutoQuill::JsonDocumentDataInterface other_data(buildRowsTemplate(other_template, 10));
+    QVERIFY(AutoQuill::LayoutCache::key(doc_template, other_data) != AutoQuill::LayoutCache::key(doc_template, data_interface));
+
+    AutoQuill::LayoutCache::Statistics statistics = cache.statistics();
+    QCOMPARE(statistics.hits, 1);
+    QCOMPARE(statistics.misses, 1);
+    QCOMPARE(statistics.stores, 1);
+
+    //layouts with plugins cannot be encoded, they are never stored
+    AutoQuill::DocumentTemplate plugin_template;
+    AutoQuill::JsonDocumentDataInterface plugin_data(buildRowsTemplate(plugin_template, 10));
+
+    pluginManager.registerPlugin("box", new ThreadSafeBoxPlugin());
+
+    AutoQuill::DocumentItem* pluginItem = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Plugin, plugin_template.subitems().first());
+    pluginItem->setInitialWidth(50);
+    pluginItem->setInitialHeight(20);
+    pluginItem->setData("box");
+    pluginItem->setObjectName("Box");
+    plugin_template.subitems().first()->insertSubItem(pluginItem);
+
+    //the plugins are part of the key
+    QVERIFY(AutoQuill::LayoutCache::key(plugin_template, plugin_data, QByteArray(), &pluginManager) !=
+            AutoQuill::LayoutCache::key(plugin_template, plugin_data));
+
+    AutoQuill::DocumentRenderer pluginRenderer(plugin_template);
+    pluginRenderer.setLayoutCache(&cache);
+
+    auto pluginResults = pluginRenderer.layoutHeadless(&plugin_data, pluginManager, &tmpPainter);
+    QCOMPARE(pluginResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    QVERIFY(!pluginResults.layout.isSerializable());
+    QVERIFY(!cache.store(QByteArray("key"), pluginResults.layout));
+
+    pluginResults = pluginRenderer.layoutHeadless(&plugin_data, pluginManager, &tmpPainter);
+    QCOMPARE(pluginResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(pluginResults.statistics.layoutCacheHits, qint64(0));
+
+    statistics = cache.statistics();
+    QCOMPARE(statistics.hits, 1);
+    QCOMPARE(statistics.stores, 1);
+}
+
+void TestLayouts::testOutputCache() {
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    QJsonObject data = buildRowsTemplate(doc_template, 30);
+
+    AutoQuill::OutputCache cache(dir.path());
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    renderer.setOutputCache(&cache);
+
+    AutoQuill::JsonDocumentDataInterface data_interface(data);
+
+    QBuffer first;
+    auto firstStatus = renderer.render(&data_interface, pluginManager, &first);
+    QCOMPARE(firstStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QVERIFY(!firstStatus.statistics.isNull());
+    QCOMPARE(firstStatus.statistics->outputCacheHits, qint64(0));
+    QVERIFY(!first.data().isEmpty());
+
+    QBuffer second;
+    auto secondStatus = renderer.render(&data_interface, pluginManager, &second);
+    QCOMPARE(secondStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(secondStatus.statistics->outputCacheHits, qint64(1));
+    QCOMPARE(second.data(), first.data());
+
+    //values which are not read by the layout do not change the hash
+    QJsonObject unusedChange = data;
+    unusedChange.insert("unused", QString("not in the template"));
+    AutoQuill::JsonDocumentDataInterface unused_interface(unusedChange);
+
+    QBuffer third;
+    auto thirdStatus = renderer.render(&unused_interface, pluginManager, &third);
+    QCOMPARE(thirdStatus.statistics->outputCacheHits, qint64(1));
+
+    //values which are read do
+    QJsonObject page = data.value("page").toObject();
+    QJsonArray rows = page.value("loop").toArray();
+    rows[0] = QString("Changed row");
+    page.insert("loop", rows);
+    QJsonObject usedChange = data;
+    usedChange.insert("page", page);
+    AutoQuill::JsonDocumentDataInterface used_interface(usedChange);
+
+    QBuffer fourth;
+    auto fourthStatus = renderer.render(&used_interface, pluginManager, &fourth);
+    QCOMPARE(fourthStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(fourthStatus.statistics->outputCacheHits, qint64(0));
+
+    AutoQuill::OutputCache::Statistics statistics = cache.statistics();
+    QCOMPARE(statistics.hits, 2);
+    QCOMPARE(statistics.misses, 2);
+    QCOMPARE(statistics.stores, 2);
+
+    AutoQuill::RecordingDataInterface recorder(&data_interface);
+    recorder.getValue("page").getValue("loop").getValue(0).getValue();
+    QCOMPARE(recorder.nReads(), 3); //the page map, the loop array, then the row value
+}
+
+void TestLayouts::testRenderFarm() {
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    QJsonObject data = buildRowsTemplate(doc_template, 30);
+
+    QString templatePath = dir.filePath("template.json");
+    QString dataPath = dir.filePath("data.json");
+    QString outputPath = dir.filePath("output.pdf");
+
+    QVERIFY(doc_template.saveTo(templatePath));
+
+    QFile dataFile(dataPath);
+    QVERIFY(dataFile.open(QIODevice::WriteOnly));
+    dataFile.write(QJsonDocument(data).toJson(QJsonDocument::Compact));
+    dataFile.close();
+
+    //the worker loop, without a process
+    QJsonObject job;
+    job.insert("id", 7);
+    job.insert("template", templatePath);
+    job.insert("data", dataPath);
+    job.insert("output", outputPath);
+
+    QJsonObject missingJob = job;
+    missingJob.insert("id", 8);
+    missingJob.insert("data", dir.filePath("missing.json"));
+
+    QBuffer input;
+    input.setData(QJsonDocument(job).toJson(QJsonDocument::Compact) + "\n" +
+                  QJsonDocument(missingJob).toJson(QJsonDocument::Compact) + "\n");
+    input.open(QIODevice::ReadOnly);
+
+    QBuffer output;
+    output.open(QIODevice::WriteOnly);
+
+    QCOMPARE(AutoQuill::RenderFarm::runWorker(input, output, pluginManager), 0);
+
+    QList<QByteArray> answers = output.data().split('\n');
+    QCOMPARE(answers.size(), 3); //two answers and the final empty line
+
+    QJsonObject answer = QJsonDocument::fromJson(answers[0]).object();
+    QCOMPARE(answer.value("id").toInt(), 7);
+    QCOMPARE(answer.value("status").toInt(), int(AutoQuill::DocumentRenderer::Success));
+    QVERIFY(answer.value("statistics").toObject().value("pages_produced").toInt() > 1);
+    QVERIFY(QFileInfo(outputPath).size() > 0);
+
+    QJsonObject failed = QJsonDocument::fromJson(answers[1]).object();
+    QCOMPARE(failed.value("id").toInt(), 8);
+    QCOMPARE(failed.value("status").toInt(), -1);
+
+    //workers which cannot start fail the jobs instead of hanging
+    AutoQuill::RenderFarm farm(dir.filePath("no-such-worker"));
+    farm.setNWorkers(2);
+
+    QVector<AutoQuill::RenderFarm::Job> jobs(3, AutoQuill::RenderFarm::Job{templatePath, dataPath, outputPath});
+    QVector<AutoQuill::RenderFarm::Result> results = farm.run(jobs);
+
+    QCOMPARE(results.size(), 3);
+
+    for (AutoQuill::RenderFarm::Result const& result : results) {
+        QVERIFY(!result.success);
+        QVERIFY(!result.message.isEmpty());
+    }
+
+    QCOMPARE(farm.statistics().jobsFailed, 3);
+    QCOMPARE(farm.statistics().jobsSucceeded, 0);
+}
+
+void TestLayouts::testRenderPageRange() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::JsonDocumentDataInterface data_interface(buildRowsTemplate(doc_template, 200));
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+
+    QBuffer full;
+    auto fullStatus = renderer.render(&data_interface, pluginManager, &full);
+    QCOMPARE(fullStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    qint64 nPages = fullStatus.statistics->pagesProduced;
+    QVERIFY(nPages > 3);
+
+    QBuffer range;
+    auto rangeStatus = renderer.renderPages(&data_interface, pluginManager, &range, 1, 2);
+    QCOMPARE(rangeStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(rangeStatus.statistics->pagesProduced, qint64(2));
+    QVERIFY(rangeStatus.statistics->nodesAllocated < fullStatus.statistics->nodesAllocated); //the last pages are not laid out
+    QVERIFY(range.data().size() < full.data().size());
+
+    //the last page is clamped to the document
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::DocumentRenderer::LayoutResults layoutResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+    QCOMPARE(layoutResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    QBuffer tail;
+    auto tailStatus = renderer.renderPages(layoutResults.layout, pluginManager, &tail, 2, 1000);
+    QCOMPARE(tailStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(tailStatus.statistics->pagesProduced, nPages-2);
+
+    QBuffer outside;
+    auto outsideStatus = renderer.renderPages(layoutResults.layout, pluginManager, &outside, 1000, 1001);
+    QCOMPARE(outsideStatus.status, AutoQuill::DocumentRenderer::Status::MissingData);
+
+    QBuffer invalid;
+    auto invalidStatus = renderer.renderPages(&data_interface, pluginManager, &invalid, 3, 1);
+    QCOMPARE(invalidStatus.status, AutoQuill::DocumentRenderer::Status::OtherError);
+}
+
+void TestLayouts::testLayoutCursor() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::JsonDocumentDataInterface data_interface(buildRowsTemplate(doc_template, 200));
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+
+    auto fullResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+    QCOMPARE(fullResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    int nPages = AutoQuill::DocumentRenderer::getLayoutNPages(fullResults.layout.items());
+    QVERIFY(nPages > 1);
+
+    QCOMPARE(renderer.nextPage().status.status, AutoQuill::DocumentRenderer::Status::OtherError); //no layout started
+
+    auto beginStatus = renderer.beginLayout(&data_interface, pluginManager, &tmpPainter);
+    QCOMPARE(beginStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    auto firstPage = renderer.nextPage();
+    QCOMPARE(firstPage.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(firstPage.layout.size(), 1);
+    QCOMPARE(firstPage.statistics.pagesProduced, qint64(1)); //only the first page has been laid out
+    QVERIFY(renderer.hasNextPage());
+
+    QBuffer firstPageOutput;
+    auto renderStatus = renderer.render(firstPage.layout, pluginManager, &firstPageOutput);
+    QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(renderStatus.statistics->pagesProduced, qint64(1));
+
+    int nCursorPages = 1;
+
+    while (renderer.hasNextPage()) {
+        auto page = renderer.nextPage();
+        QCOMPARE(page.status.status, AutoQuill::DocumentRenderer::Status::Success);
+
+        if (page.layout.isEmpty()) {
+            break;
+        }
+
+        QCOMPARE(page.layout.size(), 1);
+        nCursorPages++;
+    }
+
+    QCOMPARE(nCursorPages, nPages);
+    QVERIFY(renderer.nextPage().layout.isEmpty());
+
+    renderer.endLayout();
+    QVERIFY(!renderer.hasNextPage());
+
+    //the pages are checked against the memory budget before being laid out
+    AutoQuill::DocumentRenderer budgetRenderer(doc_template);
+    budgetRenderer.setMemoryBudget(1);
+
+    QCOMPARE(budgetRenderer.beginLayout(&data_interface, pluginManager, &tmpPainter).status, AutoQuill::DocumentRenderer::Status::Success);
+
+    auto budgetPage = budgetRenderer.nextPage();
+    QCOMPARE(budgetPage.status.status, AutoQuill::DocumentRenderer::Status::MemoryBudgetExceeded);
+    QVERIFY(budgetPage.layout.isEmpty());
+    QVERIFY(!budgetPage.status.diagnostics.isNull());
+    QCOMPARE(budgetPage.status.diagnostics->size(), 1);
+    QVERIFY(budgetPage.status.diagnostics->first().item == doc_template.subitems().first());
+    QVERIFY(!budgetRenderer.hasNextPage());
+}
+
+void TestLayouts::testDiagnostics() {
+
+    AutoQuill::RenderPluginManager pluginManager;
+
+    //page breaks are not reported
+    AutoQuill::DocumentTemplate rows_template;
+    AutoQuill::JsonDocumentDataInterface rows_data(buildRowsTemplate(rows_template, 200));
+
+    AutoQuill::DocumentRenderer rows_renderer(rows_template);
+
+    QBuffer rows_output;
+    auto rowsStatus = rows_renderer.render(&rows_data, pluginManager, &rows_output);
+    QCOMPARE(rowsStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QVERIFY(rowsStatus.diagnostics.isNull());
+    QVERIFY(rowsStatus.message.isEmpty());
+
+    //errors are reported with the item and the page
+    AutoQuill::DocumentTemplate doc_template;
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setObjectName("Page");
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* text = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, page);
+    text->setInitialWidth(700); //wider than the page
+    text->setInitialHeight(20);
+    text->setObjectName("WideText");
+    text->setData("Text");
+    page->insertSubItem(text);
+
+    AutoQuill::JsonDocumentDataInterface data_interface(QJsonObject{});
+    AutoQuill::DocumentRenderer renderer(doc_template);
+
+    QBuffer output;
+    auto status = renderer.render(&data_interface, pluginManager, &output);
+    QCOMPARE(status.status, AutoQuill::DocumentRenderer::Status::MissingSpace);
+
+    QVERIFY(!status.diagnostics.isNull());
+    QCOMPARE(status.diagnostics->size(), 1);
+
+    AutoQuill::DocumentRenderer::Diagnostic const& diagnostic = status.diagnostics->first();
+    QCOMPARE(diagnostic.code, AutoQuill::DocumentRenderer::Status::MissingSpace);
+    QCOMPARE(diagnostic.item, static_cast<AutoQuill::DocumentItem const*>(text));
+    QCOMPARE(diagnostic.page, 0);
+
+    QVERIFY(status.message.contains("WideText"));
+    QCOMPARE(status.message, AutoQuill::DocumentRenderer::diagnosticsText(*status.diagnostics));
+}
+
+/*!
+ * \brief resolvedOrigin give the actual position of an item of a layout, its currentOrigin plus the pending offsets of its parents.
+ * \return the position, or NaN coordinates if the item is not in the subtree of root.
+ */
+static QPointF resolvedOrigin(AutoQuill::ItemRenderInfos const* root, AutoQuill::ItemRenderInfos const* item, QPointF const& parentsOffset = QPointF()) {
+
+    if (root == item) {
+        return root->currentOrigin + parentsOffset;
+    }
+
+    for (AutoQuill::ItemRenderInfos const* subitem : root->subitemsRenderInfos) {
+        if (subitem == nullptr) {
+            continue;
+        }
+
+        QPointF origin = resolvedOrigin(subitem, item, parentsOffset + root->subitemsOffset);
+
+        if (!qIsNaN(origin.x())) {
+            return origin;
+        }
+    }
+
+    return QPointF(qQNaN(), qQNaN());
+}
+
+void TestLayouts::testRelativeCoordinates() {
+
+    AutoQuill::ItemRenderInfos* parent = new AutoQuill::ItemRenderInfos();
+    AutoQuill::ItemRenderInfos* child = new AutoQuill::ItemRenderInfos();
+    AutoQuill::ItemRenderInfos* grandChild = new AutoQuill::ItemRenderInfos();
+
+    parent->currentOrigin = QPointF(10, 10);
+    child->currentOrigin = QPointF(20, 30);
+    grandChild->currentOrigin = QPointF(25, 35);
+
+    child->subitemsRenderInfos.push_back(grandChild);
+    parent->subitemsRenderInfos.push_back(child);
+
+    //moving a subtree only touch its root
+    parent->translate(QPointF(5, -5));
+    child->translate(QPointF(0, 100));
+
+    QCOMPARE(parent->currentOrigin, QPointF(15, 5));
+    QCOMPARE(parent->subitemsOffset, QPointF(5, -5));
+    QCOMPARE(child->currentOrigin, QPointF(20, 130));
+    QCOMPARE(child->subitemsOffset, QPointF(0, 100));
+    QCOMPARE(grandChild->currentOrigin, QPointF(25, 35));
+
+    QCOMPARE(resolvedOrigin(parent, parent), QPointF(15, 5));
+    QCOMPARE(resolvedOrigin(parent, child), QPointF(25, 125));
+    QCOMPARE(resolvedOrigin(parent, grandChild), QPointF(30, 130));
+
+    delete parent;
+}
+
+void TestLayouts::testLoopExpandedRows() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setDataKey("page");
+    page->setObjectName("Page");
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* loop = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Loop, page);
+    loop->setInitialWidth(595);
+    loop->setInitialHeight(100);
+    loop->setDataKey("loop");
+    loop->setObjectName("Loop");
+    loop->setDirection(AutoQuill::DocumentItem::Top2Bottom);
+    page->insertSubItem(loop);
+
+    //the rows share the empty space of the loop
+    AutoQuill::DocumentItem* frame = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Frame, loop);
+    frame->setInitialWidth(595);
+    frame->setInitialHeight(20);
+    frame->setMaxWidth(595);
+    frame->setMaxHeight(20);
+    frame->setLayoutExpandBehavior(AutoQuill::DocumentItem::LayoutExpandBehavior::Expand);
+    frame->setObjectName("Row");
+    loop->insertSubItem(frame);
+
+    AutoQuill::DocumentItem* text = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, frame);
+    text->setInitialWidth(595);
+    text->setInitialHeight(20);
+    text->setMaxWidth(595);
+    text->setMaxHeight(20);
+    text->setData("Cell");
+    text->setObjectName("Cell");
+    frame->insertSubItem(text);
+
+    constexpr int nRows = 2;
+
+    QJsonArray loop_data;
+
+    for (int i = 0; i < nRows; i++) {
+        loop_data.push_back(QString("Row %1").arg(i+1));
+    }
+
+    QJsonObject page_data;
+    page_data.insert("loop", loop_data);
+
+    QJsonObject layout_data;
+    layout_data.insert("page", page_data);
+
+    AutoQuill::JsonDocumentDataInterface data_interface(layout_data);
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    auto results = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+    QCOMPARE(results.status.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    AutoQuill::ItemRenderInfos* pageInfos = results.layout[0];
+
+    AutoQuill::ItemRenderInfos* loopInfos = pageInfos->subitemsRenderInfos.first();
+    QCOMPARE(loopInfos->subitemsRenderInfos.size(), nRows);
+
+    AutoQuill::ItemRenderInfos* firstRow = loopInfos->subitemsRenderInfos[0];
+    AutoQuill::ItemRenderInfos* secondRow = loopInfos->subitemsRenderInfos[1];
+
+    QVERIFY(firstRow->currentSize.height() > 20);
+    QCOMPARE(resolvedOrigin(pageInfos, secondRow).y(), resolvedOrigin(pageInfos, firstRow).y() + firstRow->currentSize.height());
+
+    //the content of the rows moves with them
+    for (AutoQuill::ItemRenderInfos* row : {firstRow, secondRow}) {
+        QCOMPARE(row->subitemsRenderInfos.size(), 1);
+        QCOMPARE(resolvedOrigin(pageInfos, row->subitemsRenderInfos.first()), resolvedOrigin(pageInfos, row));
+    }
+}
+
+void TestLayouts::testPagesParentsOffset() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AreaRecorderPlugin* plugin = new AreaRecorderPlugin();
+    pluginManager.registerPlugin("area", plugin);
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setInitialWidth(595);
+    page->setInitialHeight(842);
+    page->setObjectName("Page");
+    doc_template.insertSubItem(page);
+
+    AutoQuill::DocumentItem* pluginItem = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Plugin, page);
+    pluginItem->setPosX(10);
+    pluginItem->setPosY(10);
+    pluginItem->setInitialWidth(50);
+    pluginItem->setInitialHeight(20);
+    pluginItem->setData("area");
+    pluginItem->setObjectName("Area");
+    page->insertSubItem(pluginItem);
+
+    AutoQuill::JsonDocumentDataInterface data_interface{QJsonObject()};
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    auto results = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+    QCOMPARE(results.status.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    AutoQuill::ItemRenderInfos* pageInfos = results.layout[0];
+    QPointF pluginOrigin = pageInfos->subitemsRenderInfos.first()->currentOrigin;
+
+    //a parent which moved its subtree, the page itself still has its original position
+    AutoQuill::DocumentItem loopItem(AutoQuill::DocumentItem::Loop);
+
+    AutoQuill::ItemRenderInfos parentInfos;
+    parentInfos.item = &loopItem;
+    parentInfos.subitemsRenderInfos.push_back(pageInfos);
+    parentInfos.translate(QPointF(100, 50));
+
+    QVector<AutoQuill::ItemRenderInfos*> pages;
+    QVector<QPointF> offsets;
+    AutoQuill::DocumentRenderer::collectLayoutPages({&parentInfos}, pages, &offsets);
+
+    parentInfos.subitemsRenderInfos.clear(); //the page belongs to the layout
+
+    QCOMPARE(pages.size(), 1);
+    QVERIFY(pages.first() == pageInfos);
+    QCOMPARE(offsets.size(), 1);
+    QCOMPARE(offsets.first(), QPointF(100, 50));
+
+    //the page is drawn where its parent moved it
+    QImage image(595, 842, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    auto renderStatus = renderer.renderItemToExternalPainter(*pages.first(), &painter, offsets.first());
+    painter.end();
+
+    QCOMPARE(renderStatus.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(plugin->areas.size(), 1);
+    QCOMPARE(plugin->areas.first().topLeft(), pluginOrigin + QPointF(100, 50));
+}
+
+void TestLayouts::testTextMeasurementsReuse() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    const int nRows = 100;
+    AutoQuill::JsonDocumentDataInterface data_interface(buildRowsTemplate(doc_template, nRows));
+
+    AutoQuill::DocumentItem* page = doc_template.subitems()[0];
+
+    AutoQuill::DocumentItem* header = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, page);
+    header->setInitialWidth(595);
+    header->setInitialHeight(20);
+    header->setMaxWidth(595);
+    header->setMaxHeight(20);
+    header->setObjectName("Header");
+    header->setData("Header");
+    header->setOverflowBehavior(AutoQuill::DocumentItem::OverflowBehavior::CopyOnNewPages);
+    page->insertSubItem(header);
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+    auto layoutResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+
+    QCOMPARE(layoutResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    QVERIFY(AutoQuill::DocumentRenderer::getLayoutNPages(layoutResults.layout.items()) > 1);
+
+    int nPages = AutoQuill::DocumentRenderer::getLayoutNPages(layoutResults.layout.items());
+
+    //each row is measured once, the header copied on new pages once per page.
+    QCOMPARE(layoutResults.statistics.paragraphsShaped, qint64(nRows + nPages));
+}
+
+void TestLayouts::testMovedTextMeasurementsReuse() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    constexpr int nRowsBefore = 3;
+    constexpr int nRows = nRowsBefore + 3;
+
+    QJsonObject layout_data = buildRowsTemplate(doc_template, nRows);
+
+    AutoQuill::DocumentItem* text = doc_template.subitems()[0]->subitems()[0]->subitems()[0];
+
+    //a row wrapped on several lines, which overflows the text block and is moved to the next page
+    QString longRow = QString("Lorem ipsum dolor sit amet, consectetur adipiscing elit. ").repeated(20);
+
+    QJsonObject page_data = layout_data.value("page").toObject();
+    QJsonArray loop_data = page_data.value("loop").toArray();
+    loop_data.replace(nRowsBefore, longRow);
+    page_data.insert("loop", loop_data);
+    layout_data.insert("page", page_data);
+
+    AutoQuill::JsonDocumentDataInterface data_interface(layout_data);
+
+    NullDevice device;
+    device.open(QIODevice::WriteOnly);
+
+    QPdfWriter writer(&device);
+    writer.setResolution(72);
+    writer.setPageMargins(QMarginsF(0,0,0,0));
+
+    QPainter tmpPainter(&writer);
+
+    AutoQuill::DocumentRenderer renderer(doc_template);
+
+    //the loop keep the measurement of the moved row for the next page
+    auto firstPageResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter, 1);
+
+    QCOMPARE(firstPageResults.status.status, AutoQuill::DocumentRenderer::Status::Success);
+    QCOMPARE(firstPageResults.layout.size(), 1);
+
+    AutoQuill::ItemRenderInfos* loopInfos = firstPageResults.layout[0]->subitemsRenderInfos[0];
+    QCOMPARE(loopInfos->subitemsRenderInfos.size(), nRowsBefore);
+    QCOMPARE(loopInfos->movedRowMeasurements.size(), 1);
+    QVERIFY(loopInfos->movedRowMeasurements.first().item == text);
+    QCOMPARE(loopInfos->movedRowMeasurements.first().lineWidth, qreal(595));
+    QVERIFY(loopInfos->movedRowMeasurements.first().height > text->maxHeight());
+
+    QCOMPARE(firstPageResults.statistics.paragraphsShaped, qint64(nRowsBefore + 1));
+
+    //the row does not fit on the next page either, but it is not broken into lines again
+    auto layoutResults = renderer.layoutHeadless(&data_interface, pluginManager, &tmpPainter);
+
+    QCOMPARE(layoutResults.status.status, AutoQuill::DocumentRenderer::Status::MissingSpace);
+    QCOMPARE(layoutResults.statistics.paragraphsShaped, qint64(nRowsBefore + 1));
+}
+
+void TestLayouts::testImagePrefetcher() {
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QImage raster(40, 20, QImage::Format_ARGB32);
+    raster.fill(Qt::red);
+
+    QString pngPath = dir.filePath("image.png");
+    QString otherPath = dir.filePath("other.png");
+    QVERIFY(raster.save(pngPath));
+    QVERIFY(raster.save(otherPath));
+
+    QString svgPath = dir.filePath("image.svg");
+    QFile svgFile(svgPath);
+    QVERIFY(svgFile.open(QIODevice::WriteOnly));
+    svgFile.write("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"10\" height=\"10\">"
+                  "<rect width=\"10\" height=\"10\" fill=\"blue\"/></svg>");
+    svgFile.close();
+
+    AutoQuill::ImagePrefetcher prefetcher;
+
+    prefetcher.prefetch(pngPath, QSizeF(40, 20));
+    prefetcher.prefetch(svgPath, QSizeF(72, 72));
+    QTRY_COMPARE(prefetcher.statistics().decoded, 2);
+
+    //prefetched images are hits, even svg images displayed at another size than the prefetched one
+    QCOMPARE(prefetcher.image(pngPath, QSizeF(40, 20)).size(), QSize(40, 20));
+    QCOMPARE(prefetcher.image(svgPath, QSizeF(36, 36)).size(), QSize(150, 150));
+    QCOMPARE(prefetcher.statistics().hits, 2);
+    QCOMPARE(prefetcher.statistics().stalls, 0);
+    QCOMPARE(prefetcher.statistics().decoded, 2); //the svg file is not read again
+
+    //images which were not prefetched are stalls
+    QVERIFY(!prefetcher.image(otherPath, QSizeF(40, 20)).isNull());
+    QCOMPARE(prefetcher.statistics().stalls, 1);
+
+    //nothing is prefetched once the cache is full
+    prefetcher.setMemoryLimit(prefetcher.memoryUsage());
+    prefetcher.prefetch(otherPath, QSizeF(40, 20));
+    QCOMPARE(prefetcher.statistics().requested, 2);
+
+    //each image item of a document is either a hit or a stall, images used twice are loaded once
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::RenderPluginManager pluginManager;
+
+    AutoQuill::DocumentItem* page = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    page->setObjectName("Page");
+    doc_template.insertSubItem(page);
+
+    for (int i = 0; i < 2; i++) {
+        AutoQuill::DocumentItem* image = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Image, page);
+        image->setPosY(i*30);
+        image->setInitialWidth(40);
+        image->setInitialHeight(20);
+        image->setObjectName(QString("Image%1").arg(i));
+        image->setData(pngPath);
+        page->insertSubItem(image);
+    }
+
+    AutoQuill::JsonDocumentDataInterface data_interface(QJsonObject{});
+    AutoQuill::DocumentRenderer renderer(doc_template);
+
+    QBuffer output;
+    auto status = renderer.render(&data_interface, pluginManager, &output);
+    QCOMPARE(status.status, AutoQuill::DocumentRenderer::Status::Success);
+
+    AutoQuill::ImagePrefetcher::Statistics statistics = renderer.imagePrefetchStatistics();
+    QCOMPARE(statistics.requested, 1);
+    QCOMPARE(statistics.decoded, 1);
+    QCOMPARE(statistics.hits + statistics.stalls, 2);
+}
+
+/*!
+ * \brief itemRowsConsistent check the rows of the subitems of an item against its subitems list and the model.
+ */
+static bool itemRowsConsistent(AutoQuill::DocumentTemplateModel & model, AutoQuill::DocumentItem* parentItem) {
+
+    QModelIndex parentIndex = model.indexFromItem(parentItem);
+
+    if (model.rowCount(parentIndex) != parentItem->subitems().size()) {
+        return false;
+    }
+
+    for (int i = 0; i < parentItem->subitems().size(); i++) {
+        AutoQuill::DocumentItem* item = parentItem->subitems()[i];
+        QModelIndex index = model.index(i, 0, parentIndex);
+
+        if (item->row() != i or model.indexFromItem(item) != index or index.internalPointer() != item) {
+            return false;
+        }
+
+        if (model.parent(index) != parentIndex) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TestLayouts::testItemRows() {
+
+    AutoQuill::DocumentTemplate doc_template;
+    AutoQuill::DocumentTemplateModel model;
+    model.setDocumentTemplate(&doc_template);
+
+    //the root items are inserted in another order than they were created in.
+    AutoQuill::DocumentItem* pageA = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    AutoQuill::DocumentItem* pageB = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Page, &doc_template);
+    model.insertItem(QModelIndex(), 0, pageA);
+    model.insertItem(QModelIndex(), 0, pageB);
+
+    QCOMPARE(pageB->row(), 0);
+    QCOMPARE(pageA->row(), 1);
+    QCOMPARE(model.indexFromItem(pageA), model.index(1, 0));
+
+    QVector<AutoQuill::DocumentItem*> texts;
+
+    for (int i = 0; i < 4; i++) {
+        AutoQuill::DocumentItem* text = new AutoQuill::DocumentItem(AutoQuill::DocumentItem::Text, pageA);
+        model.insertItem(model.indexFromItem(pageA), i, text);
+        texts.push_back(text);
+    }
+
+    QVERIFY(itemRowsConsistent(model, pageA));
+    QCOMPARE(model.parent(model.index(0, 0, model.index(1, 0))), model.index(1, 0));
+
+    //move down among the siblings, the cached rows are stale and refreshed.
+    model.moveItem(model.indexFromItem(texts[0]), 3, model.indexFromItem(pageA));
+
+    QVERIFY(pageA->subitems() == QList<AutoQuill::DocumentItem*>({texts[1], texts[2], texts[0], texts[3]}));
+    QCOMPARE(texts[0]->row(), 2);
+    QCOMPARE(texts[1]->row(), 0);
+    QVERIFY(itemRowsConsistent(model, pageA));
+
+    //move to another parent
+    model.moveItem(model.indexFromItem(texts[3]), 0, model.indexFromItem(pageB));
+
+    QCOMPARE(texts[3]->row(), 0);
+    QVERIFY(itemRowsConsistent(model, pageA));
+    QVERIFY(itemRowsConsistent(model, pageB));
+
+    //remove
+    model.removeItem(model.indexFromItem(texts[1]));
+
+    QCOMPARE(texts[1]->row(), -1);
+    QVERIFY(!model.indexFromItem(texts[1]).isValid());
+    QCOMPARE(texts[2]->row(), 0);
+    QVERIFY(itemRowsConsistent(model, pageA));
+
+    delete texts[1];
+}
+
 #include "test_layouts.moc"
 
 QTEST_MAIN(TestLayouts)
@@ -0,0 +1,75 @@
+#include "../lib/templategenerator.h"
+#include "../lib/documenttemplate.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QFile>
+
+#include <iostream>
+
+int main(int argc, char** argv) {
+
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("AutoQuillGenerator");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Generate a synthetic template and a matching json dataset, for scale testing.");
+	parser.addHelpOption();
+
+	AutoQuill::TemplateGenerator::Config config = AutoQuill::TemplateGenerator::defaultConfig();
+
+	QCommandLineOption seedOption("seed", "Seed of the generator.", "seed", QString::number(config.seed));
+	QCommandLineOption pagesOption("pages", "Number of pages items.", "n", QString::number(config.nPages));
+	QCommandLineOption depthOption("depth", "Depth of the items trees.", "n", QString::number(config.depth));
+	QCommandLineOption breadthOption("breadth", "Number of subitems per container.", "n", QString::number(config.breadth));
+	QCommandLineOption rowsOption("rows", "Number of rows in each loop.", "n", QString::number(config.nRows));
+	QCommandLineOption textOption("text-length", "Length of the texts, in characters.", "n", QString::number(config.textLength));
+	QCommandLineOption imageOption("image", "Image file used by image items (no image items if not set).", "path");
+	QCommandLineOption pluginOption("plugin", "Plugin used by plugin items (no plugin items if not set).", "name");
+
+	parser.addOptions({seedOption, pagesOption, depthOption, breadthOption, rowsOption, textOption, imageOption, pluginOption});
+
+	parser.addPositionalArgument("template", "Output template file (.aqtb for the binary format, json otherwise).");
+	parser.addPositionalArgument("data", "Output json data file.");
+
+	parser.process(app);
+
+	QStringList args = parser.positionalArguments();
+
+	if (args.size() != 2) {
+		parser.showHelp(1);
+	}
+
+	config.seed = parser.value(seedOption).toUInt();
+	config.nPages = parser.value(pagesOption).toInt();
+	config.depth = parser.value(depthOption).toInt();
+	config.breadth = parser.value(breadthOption).toInt();
+	config.nRows = parser.value(rowsOption).toInt();
+	config.textLength = parser.value(textOption).toInt();
+	config.imagePath = parser.value(imageOption);
+	config.pluginName = parser.value(pluginOption);
+
+	AutoQuill::DocumentTemplate docTemplate;
+	AutoQuill::TemplateGenerator generator(config);
+
+	generator.generateTemplate(docTemplate);
+	QJsonObject data = generator.generateData(docTemplate);
+
+	if (!docTemplate.saveTo(args[0])) {
+		std::cerr << "Could not write template file " << args[0].toStdString() << std::endl;
+		return 1;
+	}
+
+	QFile dataFile(args[1]);
+
+	if (!dataFile.open(QIODevice::WriteOnly)) {
+		std::cerr << "Could not write data file " << args[1].toStdString() << std::endl;
+		return 1;
+	}
+
+	dataFile.write(QJsonDocument(data).toJson(QJsonDocument::Compact));
+	dataFile.close();
+
+	return 0;
+}
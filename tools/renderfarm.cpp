@@ -0,0 +1,121 @@
+#include "../lib/renderfarm.h"
+#include "../lib/renderplugin.h"
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFile>
+#include <QThread>
+
+#include <iostream>
+
+int main(int argc, char** argv) {
+
+	//workers do not need a display.
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+
+	QGuiApplication app(argc, argv);
+	QGuiApplication::setApplicationName("AutoQuillRenderFarm");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Render a batch of documents on a pool of local worker processes.");
+	parser.addHelpOption();
+
+	QCommandLineOption workerOption("worker", "Run as a worker, reading jobs from the standard input.");
+	QCommandLineOption workersOption("workers", "Number of worker processes.", "n", QString::number(QThread::idealThreadCount()));
+	QCommandLineOption attemptsOption("attempts", "Number of times a job is given to a worker before it is considered failed.", "n", "2");
+
+	parser.addOptions({workerOption, workersOption, attemptsOption});
+
+	parser.addPositionalArgument("jobs", "Jobs file, one json object {\"template\", \"data\", \"output\"} per line.");
+	parser.addPositionalArgument("results", "Output json results file.");
+
+	parser.process(app);
+
+	AutoQuill::RenderPluginManager pluginManager;
+
+	if (parser.isSet(workerOption)) {
+
+		QFile input;
+		QFile output;
+
+		input.open(stdin, QIODevice::ReadOnly);
+		output.open(stdout, QIODevice::WriteOnly);
+
+		return AutoQuill::RenderFarm::runWorker(input, output, pluginManager);
+	}
+
+	QStringList args = parser.positionalArguments();
+
+	if (args.size() != 2) {
+		parser.showHelp(1);
+	}
+
+	QFile jobsFile(args[0]);
+
+	if (!jobsFile.open(QIODevice::ReadOnly)) {
+		std::cerr << "Could not read jobs file " << args[0].toStdString() << std::endl;
+		return 1;
+	}
+
+	QVector<AutoQuill::RenderFarm::Job> jobs;
+
+	while (!jobsFile.atEnd()) {
+		QByteArray line = jobsFile.readLine().trimmed();
+
+		if (line.isEmpty()) {
+			continue;
+		}
+
+		QJsonObject job = QJsonDocument::fromJson(line).object();
+		jobs.push_back({job.value("template").toString(),
+						job.value("data").toString(),
+						job.value("output").toString()});
+	}
+
+	AutoQuill::RenderFarm farm(QCoreApplication::applicationFilePath());
+	farm.setNWorkers(parser.value(workersOption).toInt());
+	farm.setMaxAttempts(parser.value(attemptsOption).toInt());
+
+	QVector<AutoQuill::RenderFarm::Result> results = farm.run(jobs);
+	AutoQuill::RenderFarm::Statistics const& statistics = farm.statistics();
+
+	QJsonArray jobsResults;
+
+	for (int i = 0; i < results.size(); i++) {
+		QJsonObject result;
+		result.insert("output", jobs[i].outputPath);
+		result.insert("success", results[i].success);
+		result.insert("status", results[i].status);
+		result.insert("message", results[i].message);
+		result.insert("attempts", results[i].attempts);
+		result.insert("statistics", results[i].statistics);
+		jobsResults.append(result);
+	}
+
+	QJsonObject farmStatistics;
+	farmStatistics.insert("workers_started", statistics.workersStarted);
+	farmStatistics.insert("workers_crashed", statistics.workersCrashed);
+	farmStatistics.insert("jobs_succeeded", statistics.jobsSucceeded);
+	farmStatistics.insert("jobs_failed", statistics.jobsFailed);
+	farmStatistics.insert("wall_ns", statistics.wallNs);
+
+	QJsonObject report;
+	report.insert("jobs", jobsResults);
+	report.insert("statistics", farmStatistics);
+
+	QFile resultsFile(args[1]);
+
+	if (!resultsFile.open(QIODevice::WriteOnly)) {
+		std::cerr << "Could not write results file " << args[1].toStdString() << std::endl;
+		return 1;
+	}
+
+	resultsFile.write(QJsonDocument(report).toJson());
+	resultsFile.close();
+
+	return (statistics.jobsFailed == 0) ? 0 : 2;
+}